@@ -0,0 +1,104 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   AsyncDatabaseWriter.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_REPOSITORY_ASYNCDATABASEWRITER_H
+#define QC_REPOSITORY_ASYNCDATABASEWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+// QC
+#include "QualityControl/DatabaseInterface.h"
+#include "QualityControl/ThreadPool.h"
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Stores MonitorObjects in the background, so that the callers do not wait for the database.
+///
+/// The objects are queued and stored by the threads of a ThreadPool, each store using one of the connections to the
+/// database which is not in use.
+/// If a new version of an object arrives while the previous one is still waiting in the queue, the previous one is
+/// replaced (coalesced) and keeps its place in the queue. Two versions of the same object are never stored
+/// concurrently, thus they are stored in order. When the queue is full, the caller either waits (Block) or the
+/// incoming object is dropped (Drop).
+class AsyncDatabaseWriter
+{
+ public:
+  enum class QueueFullPolicy { Block,
+                               Drop };
+
+  struct Statistics {
+    unsigned long stored = 0;    // objects successfully stored
+    unsigned long failed = 0;    // objects whose storage failed
+    unsigned long coalesced = 0; // objects replaced in the queue by a newer version
+    unsigned long dropped = 0;   // objects dropped because the queue was full
+    size_t queueSize = 0;        // objects currently waiting
+  };
+
+  /// \param databaseCreator - called once per writer, it returns a database ready to be used
+  /// \param numberOfWriters - number of threads and of connections to the database, at least one
+  /// \param capacity - maximum number of objects waiting in the queue
+  AsyncDatabaseWriter(std::function<std::unique_ptr<DatabaseInterface>()> databaseCreator, size_t numberOfWriters,
+                      size_t capacity, QueueFullPolicy policy = QueueFullPolicy::Block);
+  /// \brief Stores the objects still in the queue and stops the writers.
+  ~AsyncDatabaseWriter();
+
+  /// \brief Queues the object for storage. It is not to be modified anymore by the caller.
+  /// \param onStored - called with the result of the storage, true if it succeeded, from the thread which stored the
+  ///                   object or from the caller if it is dropped. It is not called if the object is replaced in the
+  ///                   queue by a newer version, whose callback is called instead.
+  void store(std::shared_ptr<core::MonitorObject> mo, std::function<void(bool)> onStored = nullptr);
+  /// \brief Waits until all the objects queued so far are stored.
+  void flush();
+  Statistics getStatistics();
+
+  static QueueFullPolicy policyFromString(const std::string& policy);
+
+ private:
+  /// \brief Submits the next objects to the pool, as long as a database is idle. To be called with the mutex locked.
+  void schedule();
+  struct PendingObject {
+    std::shared_ptr<core::MonitorObject> mo;
+    std::function<void(bool)> onStored;
+  };
+
+  void write(DatabaseInterface& database, const std::string& key, PendingObject object);
+  /// \brief Gives the database back to the idle ones and counts the object as stored or failed.
+  void release(DatabaseInterface& database, const std::string& key, bool success);
+
+  std::vector<std::unique_ptr<DatabaseInterface>> mDatabases; // one per writer
+  std::vector<DatabaseInterface*> mIdleDatabases;
+  size_t mCapacity;
+  QueueFullPolicy mPolicy;
+
+  std::mutex mMutex;
+  std::condition_variable mObjectStored;
+  std::deque<std::string> mQueue;                                                // keys, in order of arrival
+  std::unordered_map<std::string, PendingObject> mPending;                         // key -> latest version
+  std::unordered_set<std::string> mInFlight;                                     // keys being stored
+  Statistics mStatistics;
+  core::ThreadPool mPool; // last, so that its threads are stopped before the other members are destroyed
+};
+
+} // namespace o2::quality_control::repository
+
+#endif // QC_REPOSITORY_ASYNCDATABASEWRITER_H
@@ -0,0 +1,91 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   BackgroundPublisher.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_BACKGROUNDPUBLISHER_H
+#define QC_CORE_BACKGROUNDPUBLISHER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+// ROOT
+#include <TBufferFile.h>
+#include <TObjArray.h>
+// O2
+#include "Framework/DataAllocator.h"
+// QC
+#include "QualityControl/MonitorObject.h"
+#include "QualityControl/MonitorObjectsSerializer.h"
+
+namespace o2::quality_control::core
+{
+
+/// \brief Serializes the MonitorObjects of a task in a background thread.
+///
+/// The objects to publish are copied into a back buffer, which is then serialized by a background thread while the
+/// task keeps filling the original ones. Histograms are copied in place into the back buffer, without reallocation
+/// after the first cycle, other objects are cloned. The copies are matched to the objects by the names of their
+/// MonitorObjects, those of the objects which are not published anymore are deleted. The serialized message is sent at one of the next invocations of
+/// the processing callback, because the DataAllocator can be used only from there.
+class BackgroundPublisher
+{
+ public:
+  BackgroundPublisher();
+  ~BackgroundPublisher();
+
+  /// \brief Copies the objects into the back buffer and starts their serialization.
+  /// If the previous serialization is not over yet, it waits for it. Thus send() with wait = true should be called
+  /// beforehand, otherwise a serialized message which was not sent yet would be lost.
+  void publish(const TObjArray& objects);
+  /// \brief Sends the serialized objects, if any.
+  /// \param wait - if true, the ongoing serialization (if any) is waited for.
+  /// \return true if a message was sent.
+  bool send(framework::DataAllocator& outputs, const framework::Output& output, bool wait = false);
+  /// \brief Duration of the serialization of the last message sent, in ms.
+  double getLastSerializationDuration() const { return mLastSerializationDuration; }
+  /// \brief Duration of the copy of the last message sent into the message of the framework, in ms.
+  double getLastSendDuration() const { return mLastSendDuration; }
+
+ private:
+  void run();
+  /// \brief Copies the object into copy, in place if it is a histogram of the same class, otherwise with a clone.
+  void copyToBackBuffer(const TObject* object, std::unique_ptr<TObject>& copy);
+
+  struct BackObject {
+    std::unique_ptr<TObject> copy;
+    uint64_t publication; // number of the last publication of the object
+  };
+  // name of the MonitorObject -> copy of its object, only for the objects of the last publication
+  std::unordered_map<std::string, BackObject> mBackObjects;
+  uint64_t mPublications;                  // number of calls to publish
+  std::unique_ptr<TObjArray> mToSerialize; // MonitorObjects of the back buffer
+  MonitorObjectsSerializer mSerializer;    // serializes in the background thread, its buffer is sent by send()
+  bool mSerialized;                        // whether the buffer of the serializer holds a message not sent yet
+  double mSerializationDuration;
+  double mLastSerializationDuration;
+  double mLastSendDuration;
+  bool mSerializing;
+  bool mStopping;
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::thread mThread;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_BACKGROUNDPUBLISHER_H
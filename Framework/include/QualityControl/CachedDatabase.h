@@ -0,0 +1,147 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CachedDatabase.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_REPOSITORY_CACHEDDATABASE_H
+#define QC_REPOSITORY_CACHEDDATABASE_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// QC
+#include "QualityControl/DatabaseInterface.h"
+#include "QualityControl/ThreadPool.h"
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Read-through cache in front of another DatabaseInterface.
+///
+/// The latest version of each object read with retrieve, retrieveMany or retrieveJson is kept in memory, together
+/// with its JSON once it has been asked for, so that the repeated reads of a GUI do not fetch, deserialize and convert
+/// the object again. The least recently used objects are evicted when the memory budget is exceeded, and the objects
+/// older than the time to live are fetched again, which bounds how long a version stored by another process is
+/// ignored. The objects stored or truncated through this class are invalidated immediately. Those stored with
+/// storeAsync are invalidated again when their storage is over, as a read made in the meantime caches the version
+/// they replace. A thread of the class waits for the storages to be over, in order.
+///
+/// retrieve and retrieveMany return copies of the cached objects, which the callers can modify and which own the
+/// object they wrap. The cache can be
+/// used from several threads, provided ROOT::EnableThreadSafety() has been called.
+class CachedDatabase : public DatabaseInterface
+{
+ public:
+  struct Statistics {
+    unsigned long hits = 0;        // reads served from memory
+    unsigned long misses = 0;      // reads forwarded to the database
+    unsigned long expirations = 0; // entries dropped because they were older than the time to live
+    unsigned long evictions = 0;   // entries dropped to stay within the memory budget
+    size_t entries = 0;            // objects currently cached
+    size_t bytes = 0;              // estimated memory used by the cached objects and JSONs
+  };
+
+  static constexpr size_t defaultMemoryBudget = 256 * 1024 * 1024;
+  static constexpr std::chrono::milliseconds defaultTimeToLive{ 10000 };
+
+  /// \param database - the database actually accessed
+  /// \param memoryBudget - maximum number of bytes used by the cached objects and JSONs, estimated from their
+  ///                       serialized size
+  /// \param timeToLive - age after which a cached object is fetched again, 0 for no limit
+  explicit CachedDatabase(std::unique_ptr<DatabaseInterface> database, size_t memoryBudget = defaultMemoryBudget,
+                          std::chrono::milliseconds timeToLive = defaultTimeToLive);
+  ~CachedDatabase() override = default;
+
+  void connect(std::string host, std::string database, std::string username, std::string password) override;
+  /**
+   * Connects the underlying database. The keys "cacheMemoryBudget" (MB) and "cacheTimeToLive" (ms) of the
+   * configuration, if present, replace the values given to the constructor.
+   */
+  void connect(const std::unordered_map<std::string, std::string>& config) override;
+  void store(std::shared_ptr<core::MonitorObject> mo) override;
+  std::future<void> storeAsync(std::shared_ptr<core::MonitorObject> mo) override;
+  void flush() override;
+  core::MonitorObject* retrieve(std::string taskName, std::string objectName) override;
+  /**
+   * Only the objects which are not cached are asked to the underlying database, with a single call to retrieveMany.
+   */
+  std::vector<std::shared_ptr<core::MonitorObject>> retrieveMany(std::string taskName,
+                                                                 const std::vector<std::string>& objectNames) override;
+  /**
+   * Returns the cached JSON, or converts the cached object. The object is fetched only if it is not cached.
+   */
+  std::string retrieveJson(std::string taskName, std::string objectName) override;
+  void disconnect() override;
+  void prepareTaskDataContainer(std::string taskName) override;
+  std::vector<std::string> getListOfTasksWithPublications() override;
+  std::vector<std::string> getPublishedObjectNames(std::string taskName) override;
+  void truncate(std::string taskName, std::string objectName) override;
+
+  /// \brief Drops the cached version of an object, the next read fetches it from the database.
+  void invalidate(const std::string& taskName, const std::string& objectName);
+  /// \brief Drops all the cached objects.
+  void clear();
+  Statistics getStatistics();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::shared_ptr<const core::MonitorObject> object;
+    std::shared_ptr<const std::string> json; // nullptr until asked for
+    size_t objectSize;
+    Clock::time_point fetched;
+    std::list<std::string>::iterator lruPosition;
+  };
+
+  static std::string key(const std::string& taskName, const std::string& objectName);
+  static size_t estimateSize(const core::MonitorObject& object);
+  static core::MonitorObject* copy(const core::MonitorObject& object);
+  /// Retrieves an object from the database, with the ownership of the object it wraps.
+  std::shared_ptr<const core::MonitorObject> fetch(const std::string& taskName, const std::string& objectName);
+
+  /// Returns the cached object, or nullptr if it is not cached or expired, and records the hit or the miss.
+  /// version is set to the version of the key, to be passed to insert once the object is fetched. json, if given, is
+  /// set to the cached JSON of the object, if any.
+  std::shared_ptr<const core::MonitorObject> lookup(const std::string& key, uint64_t& version,
+                                                    std::shared_ptr<const std::string>* json = nullptr);
+  /// Caches an object fetched from the database, unless it was invalidated since version was obtained.
+  void insert(const std::string& key, uint64_t version, std::shared_ptr<const core::MonitorObject> object);
+  /// Adds the JSON to the entry of the object, if it is still cached.
+  void insertJson(const std::string& key, const std::shared_ptr<const core::MonitorObject>& object,
+                  std::shared_ptr<const std::string> json);
+  void erase(std::unordered_map<std::string, Entry>::iterator entry);
+  void evict();
+
+  std::unique_ptr<DatabaseInterface> mDatabase;
+  size_t mMemoryBudget;
+  std::chrono::milliseconds mTimeToLive;
+
+  std::mutex mMutex;
+  std::unordered_map<std::string, Entry> mEntries;
+  std::list<std::string> mLru; // keys, the most recently used first
+  // Incremented each time an object is stored or truncated, so that a read racing with them does not cache the
+  // version they replaced.
+  std::unordered_map<std::string, uint64_t> mVersions;
+  Statistics mStatistics;
+  core::ThreadPool mStorages; // waits for the storeAsync to be over, last to be stopped before the other members
+};
+
+} // namespace o2::quality_control::repository
+
+#endif // QC_REPOSITORY_CACHEDDATABASE_H
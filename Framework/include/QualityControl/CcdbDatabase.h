@@ -16,8 +16,13 @@
 #ifndef QC_REPOSITORY_CCDBDATABASE_H
 #define QC_REPOSITORY_CCDBDATABASE_H
 
+#include <map>
+#include <mutex>
+#include <string>
 #include "CCDB/CcdbApi.h"
+#include "QualityControl/CcdbUploader.h"
 #include "QualityControl/DatabaseInterface.h"
+#include "QualityControl/ThreadPool.h"
 
 namespace o2::quality_control::repository
 {
@@ -55,7 +60,21 @@ class CcdbDatabase : public DatabaseInterface
   void connect(std::string host, std::string database, std::string username, std::string password) override;
   void connect(const std::unordered_map<std::string, std::string>& config) override;
   void store(std::shared_ptr<o2::quality_control::core::MonitorObject> mo) override;
+  /**
+   * Serializes the object and queues it for upload. Up to "uploadConnections" (configuration of the database,
+   * 4 by default) uploads are in flight concurrently, each on its own persistent connection.
+   */
+  std::future<void> storeAsync(std::shared_ptr<o2::quality_control::core::MonitorObject> mo) override;
+  /**
+   * Can be called from several threads, the requests are then made one after the other.
+   */
   core::MonitorObject* retrieve(std::string taskName, std::string objectName) override;
+  /**
+   * Retrieves the objects in parallel, with up to "fetchConnections" (configuration of the database, 4 by default)
+   * concurrent requests, each with its own CcdbApi.
+   */
+  std::vector<std::shared_ptr<core::MonitorObject>> retrieveMany(std::string taskName,
+                                                                 const std::vector<std::string>& objectNames) override;
   std::string retrieveJson(std::string taskName, std::string objectName) override;
   void disconnect() override;
   void prepareTaskDataContainer(std::string taskName) override;
@@ -63,7 +82,18 @@ class CcdbDatabase : public DatabaseInterface
   std::vector<std::string> getPublishedObjectNames(std::string taskName) override;
   void truncate(std::string taskName, std::string objectName) override;
 
+  /**
+   * Returns the URL to which storeAsync() posts an object. CcdbApi::store builds it privately, this is the only copy
+   * of its layout : <host>/<path>/<from>/<to>/<key>=<value>/... , with the validity in ms since the epoch. It must
+   * follow CcdbApi::store when the latter changes, testDbFactory checks it.
+   */
+  static std::string getStorageUrl(const std::string& host, const std::string& path,
+                                   const std::map<std::string, std::string>& metadata, long from, long to);
+
  private:
+  static constexpr size_t defaultUploadConnections = 4;
+  static constexpr size_t defaultFetchConnections = 4;
+
   long getCurrentTimestamp();
   std::string getTimestampString(long timestamp);
   long getFutureTimestamp(int secondsInFuture);
@@ -74,8 +104,15 @@ class CcdbDatabase : public DatabaseInterface
    * @return The listing of folder and/or objects in the format requested and as returned by the http server.
    */
   std::string getListing(std::string subpath = "", std::string accept = "text/plain");
+  core::MonitorObject* retrieve(o2::ccdb::CcdbApi& api, const std::string& taskName, const std::string& objectName);
+  void createFetchers(size_t fetchConnections);
+
   o2::ccdb::CcdbApi ccdbApi;
+  std::mutex mApiMutex; // nothing tells that CcdbApi can be used concurrently, ccdbApi is used by one caller at a time
   std::string mUrl;
+  std::unique_ptr<CcdbUploader> mUploader;
+  std::vector<std::unique_ptr<o2::ccdb::CcdbApi>> mFetchApis; // one per thread of mFetchers
+  std::unique_ptr<core::ThreadPool> mFetchers;
 };
 
 } // namespace o2::quality_control::repository
@@ -0,0 +1,88 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CcdbUploader.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_REPOSITORY_CCDBUPLOADER_H
+#define QC_REPOSITORY_CCDBUPLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+// QC
+#include "QualityControl/ThreadPool.h"
+
+class TMessage;
+typedef void CURL;
+struct curl_slist;
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Uploads serialized objects to the CCDB with several concurrent requests on persistent connections.
+///
+/// Each connection is a curl handle, which keeps its HTTP connection (keep-alive) from one upload to the next. The
+/// uploads are queued and given to the first idle connection, which performs them on a ThreadPool, so up to
+/// numberOfConnections uploads are in flight at the same time. The requests are the same as the ones of
+/// o2::ccdb::CcdbApi::store, i.e. a multipart POST of the serialized object to the given URL.
+class CcdbUploader
+{
+ public:
+  /// \param numberOfConnections - number of concurrent uploads, at least 1
+  /// \param capacity - maximum number of queued uploads, upload() blocks when it is reached
+  CcdbUploader(size_t numberOfConnections, size_t capacity);
+  /// \brief Finishes the queued uploads and closes the connections.
+  ~CcdbUploader();
+
+  /// \brief Queues the upload of a serialized object.
+  /// \param url - full URL of the object, i.e. including the path, the validity and the metadata
+  /// \param fileName - name of the file given in the multipart form
+  /// \param message - serialized object
+  /// \return a future which becomes ready when the upload is finished, holding a DatabaseException if it failed.
+  std::future<void> upload(std::string url, std::string fileName, std::unique_ptr<TMessage> message);
+  /// \brief Waits until all the uploads queued so far are finished.
+  void flush();
+
+  size_t getNumberOfConnections() const { return mHandles.size(); }
+
+ private:
+  struct Upload {
+    std::string url;
+    std::string fileName;
+    std::unique_ptr<TMessage> message;
+    std::promise<void> promise;
+  };
+
+  /// \brief Submits the queued uploads to the pool while a connection is idle. To be called with the mutex locked.
+  void schedule();
+  void perform(CURL* curl, Upload& upload);
+
+  std::vector<CURL*> mHandles; // one per connection
+  std::vector<CURL*> mIdleHandles;
+  curl_slist* mHeaders;
+  size_t mCapacity;
+
+  std::mutex mMutex;
+  std::condition_variable mUploadDone;
+  std::deque<Upload> mQueue;
+  size_t mInFlight;
+  core::ThreadPool mPool; // last, so that its threads are stopped before the other members are destroyed
+};
+
+} // namespace o2::quality_control::repository
+
+#endif // QC_REPOSITORY_CCDBUPLOADER_H
@@ -10,16 +10,21 @@
 // std & boost
 #include <chrono>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 // O2
 #include <Common/Timer.h>
 #include <Configuration/ConfigurationInterface.h>
 #include <Framework/Task.h>
 #include <Monitoring/MonitoringFactory.h>
 // QC
+#include "QualityControl/AsyncDatabaseWriter.h"
 #include "QualityControl/CheckInterface.h"
 #include "QualityControl/DatabaseInterface.h"
 #include "QualityControl/MonitorObject.h"
 #include "QualityControl/QcInfoLogger.h"
+#include "QualityControl/StorageDeduplicator.h"
+#include "QualityControl/ThreadPool.h"
 
 namespace o2::quality_control::checker
 {
@@ -56,30 +61,61 @@ class Checker : public framework::Task
   static o2::header::DataDescription createCheckerDataDescription(const std::string taskName);
 
  private:
+  /// A check to run, already loaded and instantiated : its name and its instance.
+  using ResolvedCheck = std::pair<std::string, CheckInterface*>;
+
+  /// The checks of an object, resolved once and reused as long as the definitions of the checks do not change.
+  struct CheckPlan {
+    std::vector<CheckDefinition> definitions; // the definitions the plan was built from
+    std::vector<ResolvedCheck> checks;
+  };
+
+  /**
+   * \brief Get the plan of the checks associated with a MonitorObject.
+   *
+   * The plan is built the first time an object is seen, or when its check definitions change : the libraries are
+   * loaded and the checks instantiated if needed. It is not thread-safe.
+   *
+   * @param mo The MonitorObject whose checks are requested.
+   * @return The plan, its checks are ready to be passed to check().
+   */
+  std::shared_ptr<const CheckPlan> resolveChecks(const MonitorObject& mo);
+
   /**
    * \brief Evaluate the quality of a MonitorObject.
    *
    * The Check's associated with this MonitorObject are run and a global quality is built by
    * taking the worse quality encountered. The MonitorObject is modified by setting its quality
    * and by calling the "beautifying" methods of the Check's.
+   * It can be called concurrently for different MonitorObjects, since the Check's are stateless.
    *
    * @param mo The MonitorObject to evaluate and whose quality will be set according
    *        to the worse quality encountered while running the Check's.
+   * @param checks The Check's of this MonitorObject, as returned by resolveChecks().
+   * @return The quality given by each Check, in the same order.
    */
-  void check(std::shared_ptr<MonitorObject> mo);
+  std::vector<Quality> check(std::shared_ptr<MonitorObject> mo, const std::vector<ResolvedCheck>& checks);
 
   /**
    * \brief Store the MonitorObject in the database.
+   * If the storage is asynchronous, the object is only queued and must not be modified anymore.
+   * If the storage is deduplicated, a failure is reported to the deduplicator.
    *
    * @param mo The MonitorObject to be stored in the database.
+   * @param content The content of the MonitorObject, if the storage is deduplicated.
    */
-  void store(std::shared_ptr<MonitorObject> mo);
+  void store(std::shared_ptr<MonitorObject> mo, const StorageDeduplicator::Content& content);
 
   /**
    * \brief Send the MonitorObject on FairMQ to whoever is listening.
    */
   void send(std::unique_ptr<TObjArray>& mo, framework::DataAllocator& allocator);
 
+  /**
+   * \brief Send the metrics of the asynchronous storage, if enabled.
+   */
+  void sendStorageStatistics();
+
   /**
    * \brief Load a library.
    * Load a library if it is not already in the cache.
@@ -103,13 +139,21 @@ class Checker : public framework::Task
   std::string mConfigurationSource;
   o2::quality_control::core::QcInfoLogger& mLogger;
   std::shared_ptr<o2::quality_control::repository::DatabaseInterface> mDatabase;
+  std::unique_ptr<o2::quality_control::repository::AsyncDatabaseWriter> mDatabaseWriter; // if the storage is asynchronous
+
+  // Storage deduplication, the objects identical to their last stored version are not stored again
+  std::unique_ptr<StorageDeduplicator> mDeduplicator; // if the storage is deduplicated
 
   // DPL
   o2::framework::InputSpec mInputSpec;
   o2::framework::OutputSpec mOutputSpec;
 
+  // Checks execution, in parallel if there is a pool
+  std::unique_ptr<o2::quality_control::core::ThreadPool> mThreadPool;
+
   // Checks cache
-  std::vector<std::string> mLibrariesLoaded;
+  std::unordered_set<std::string> mLibrariesLoaded;
+  std::unordered_map<std::string /*object name*/, std::shared_ptr<const CheckPlan>> mCheckPlans;
   std::map<std::string, CheckInterface*> mChecksLoaded;
   std::map<std::string, TClass*> mClassesLoaded;
 
@@ -0,0 +1,44 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CycleHeader.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_CYCLEHEADER_H
+#define QC_CORE_CYCLEHEADER_H
+
+#include <cstdint>
+// O2
+#include "Headers/DataHeader.h"
+
+namespace o2::quality_control::core
+{
+
+/// \brief Header added to the messages of MonitorObjects, with the number of the cycle they were published in.
+///
+/// The tasks count their cycles from 0, the mergers forward the number of the cycle they published. The receivers
+/// can thus tell which cycle each input is at, whatever the number of messages they received or missed.
+struct CycleHeader : public o2::header::BaseHeader {
+  static constexpr o2::header::HeaderType sHeaderType = "QcCycle";
+  static constexpr uint32_t sVersion = 1;
+
+  explicit CycleHeader(uint64_t cycle)
+    : BaseHeader(sizeof(CycleHeader), sHeaderType, o2::header::gSerializationMethodNone, sVersion), cycle(cycle)
+  {
+  }
+
+  uint64_t cycle;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_CYCLEHEADER_H
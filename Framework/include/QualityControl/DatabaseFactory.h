@@ -22,9 +22,10 @@ class DatabaseFactory
   /// \brief Create a new instance of a DatabaseInterface.
   /// The DatabaseInterface actual class is decided based on the parameters passed.
   /// The ownership is returned as well.
-  /// \param name Possible values : "MySql", "CCDB"
+  /// \param name Possible values : "MySql", "CCDB", "Local"
+  /// \param cache Whether the objects read are kept in memory, the database is then wrapped in a CachedDatabase.
   /// \author Barthelemy von Haller
-  static std::unique_ptr<DatabaseInterface> create(std::string name);
+  static std::unique_ptr<DatabaseInterface> create(std::string name, bool cache = false);
 };
 
 } // namespace o2::quality_control::repository
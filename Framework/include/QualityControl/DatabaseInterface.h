@@ -7,8 +7,11 @@
 #define QC_REPOSITORY_DATABASEINTERFACE_H
 
 #include "QualityControl/MonitorObject.h"
+#include <future>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 //#include <bits/unique_ptr.h>
 
 namespace o2::quality_control::repository
@@ -48,15 +51,68 @@ class DatabaseInterface
    */
   virtual void store(std::shared_ptr<o2::quality_control::core::MonitorObject> mo) = 0;
 
+  /**
+   * Stores the serialized MonitorObject in the database, without waiting for the end of the operation if the
+   * implementation supports it. The object can be modified as soon as the call returns.
+   * The default implementation stores synchronously.
+   * @param mo The MonitorObject to serialize and store.
+   * @return A future which becomes ready when the object is stored, holding the exception if it failed.
+   */
+  virtual std::future<void> storeAsync(std::shared_ptr<o2::quality_control::core::MonitorObject> mo)
+  {
+    std::promise<void> stored;
+    try {
+      store(mo);
+      stored.set_value();
+    } catch (...) {
+      stored.set_exception(std::current_exception());
+    }
+    return stored.get_future();
+  }
+
+  /**
+   * Waits until the objects stored so far are written, for the implementations which write them in the background.
+   * The default implementation does nothing, the objects being written by store.
+   */
+  virtual void flush() {}
+
   /**
    * Look up an object of a task and return it.
    * \details It returns the object if found or nullptr if not.
    * TODO evaluate whether we should have more methods to retrieve objects of different types (with or without
    * templates)
-   * TODO evaluate whether we should have a method to retrieve a list of objects (optimization)
    */
   virtual o2::quality_control::core::MonitorObject* retrieve(std::string taskName, std::string objectName) = 0;
 
+  /**
+   * Look up several objects of a task and return them.
+   * \details The objects which are not found are not part of the result, the others are in the order of objectNames.
+   * The objects own the object they wrap, which is deleted along with them. The default implementation calls retrieve for each object, the implementations should rather amortize the round
+   * trips to the database.
+   */
+  virtual std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>>
+    retrieveMany(std::string taskName, const std::vector<std::string>& objectNames)
+  {
+    std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> objects;
+    for (const auto& objectName : objectNames) {
+      if (auto* mo = retrieve(taskName, objectName)) {
+        mo->setIsOwner(true); // it is streamed as it was published, by a task which does not give the ownership
+        objects.emplace_back(mo);
+      }
+    }
+    return objects;
+  }
+
+  /**
+   * Look up all the objects published by a task and return them.
+   * \details The objects own the object they wrap, as the ones of retrieveMany.
+   * The default implementation retrieves the objects listed by getPublishedObjectNames with retrieveMany.
+   */
+  virtual std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> retrieveAll(std::string taskName)
+  {
+    return retrieveMany(taskName, getPublishedObjectNames(taskName));
+  }
+
   /**
    * Returns JSON encoded object
    */
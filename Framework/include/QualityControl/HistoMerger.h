@@ -7,25 +7,32 @@
 #define QC_CORE_HISTOMERGER_H
 
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Common/Timer.h"
+#include <Framework/DataRef.h>
 #include <Framework/Task.h>
 #include <Headers/DataHeader.h>
 #include <TH1.h>
 
 #include "QualityControl/MonitorObject.h"
+#include "QualityControl/ObjectMerger.h"
 
 namespace o2::quality_control::core
 {
 
+struct CycleHeader;
+
 /// \brief A crude histogram merger for development purposes.
 ///
 /// A crude histogram merger for development purposes - at some point, it will be substituted with more fine solution.
-/// As inputs, it expects updates of MonitorObjects with one TH1 histogram each, which are accumulated into one
-/// MonitorObject. The joined MO is published on regular basis with a period specified in the constructor. All inputs
-/// should have the same DataOrigin and DataDescription and non-zero SubSpecification. Output has the same origin and
-/// description as inputs, but SubSpec is fixed 0.
+/// As inputs, it expects arrays of MonitorObjects, whose objects are accumulated by name with the ObjectMerger, i.e.
+/// any histogram or object with a Merge method. The other objects keep their first version. The joined MOs are
+/// published on regular basis with a period specified in the constructor. All inputs should have the same DataOrigin
+/// and DataDescription and non-zero SubSpecification. Output has the same origin and description as inputs, but SubSpec
+/// is 0 unless configured otherwise.
 class HistoMerger : public framework::Task
 {
  public:
@@ -41,19 +48,58 @@ class HistoMerger : public framework::Task
   /// \brief HistoMerger process callback
   void run(framework::ProcessingContext& ctx) override;
 
+  /// \brief Merges the arrays of MonitorObjects received in one invocation, as run() does before publishing.
+  void merge(const std::vector<framework::DataRef>& inputs);
+  /// \brief The merged objects, in the order they were first received. They are owned by the merger.
+  const TObjArray& getMergedObjects() const { return mMergedArray; }
+  /// \brief Whether the merged objects are to be published now, because all the inputs sent the next cycle (if
+  /// publishing on completion) or because the publication period is over. The cycle is then considered published.
+  bool preparePublication();
+  /// \brief Number of the next cycle to be published, i.e. the last one published + 1, 0 if none was published.
+  size_t getNextCycle() const { return mPublishedCycles; }
+
   void configureInputsOutputs(
     o2::header::DataOrigin origin, o2::header::DataDescription description,
     std::pair<o2::header::DataHeader::SubSpecificationType, o2::header::DataHeader::SubSpecificationType> subSpecRange);
 
+  /// \brief Configures the inputs and the output with explicit SubSpecifications, e.g. for a merger inside a tree.
+  void configureInputsOutputs(o2::header::DataOrigin origin, o2::header::DataDescription description,
+                              const std::vector<o2::header::DataHeader::SubSpecificationType>& inputSubSpecs,
+                              o2::header::DataHeader::SubSpecificationType outputSubSpec);
+
+  /// \brief If set, the merged objects are cleared after each publication, thus only the updates received in the
+  /// meantime are published. It is meant for the mergers which feed other mergers, since those accumulate.
+  void setResetAfterPublication(bool reset) { mResetAfterPublication = reset; }
+
+  /// \brief If set, the merged objects are published as soon as all the inputs sent their objects of the next cycle,
+  /// the publication period is then only a timeout for the inputs which are late or gone.
+  void setPublicationOnCompletion(bool onCompletion) { mPublicationOnCompletion = onCompletion; }
+
   std::string getName() { return mMergerName; };
   std::vector<o2::framework::InputSpec> getInputSpecs() { return mInputSpecs; };
   framework::OutputSpec getOutputSpec() { return mOutputSpec; };
 
  private:
+  /// \brief Whether every input sent the objects of a cycle which was not published yet.
+  bool isCycleComplete() const;
+  /// \brief Updates the next cycle expected from an input with the header of a message it sent.
+  void updateCycle(size_t& received, const CycleHeader* cycleHeader);
+  void publish(framework::ProcessingContext& ctx);
+
   // General state
   std::string mMergerName;
-  TObjArray mMergedArray;
+  TObjArray mMergedArray; // owns the merged objects, in the order they were first received
+  std::unordered_map<std::string, MonitorObject*> mMergedIndex; // the merged objects by name
   AliceO2::Common::Timer mPublicationTimer;
+  int mPublicationPeriodUs;
+  bool mResetAfterPublication = false;
+  bool mPublicationOnCompletion = false;
+  // Cycle following the last one received from each input, by SubSpec, and cycle following the last one published.
+  // The cycles are given by the CycleHeader of the messages, or counted if there is none.
+  std::unordered_map<o2::header::DataHeader::SubSpecificationType, size_t> mReceivedCycles;
+  size_t mPublishedCycles = 0;
+  ObjectMerger mObjectMerger;
+  std::unordered_set<std::string> mNotMergeable; // names of the objects which could not be merged, warned once
 
   // DPL
   std::vector<o2::framework::InputSpec> mInputSpecs;
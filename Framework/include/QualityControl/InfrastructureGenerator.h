@@ -68,6 +68,26 @@ class InfrastructureGenerator
   /// \param configurationSource - full path to configuration file, preceded with the backend (f.e. "json://")
   /// \return generated remote QC workflow
   static void generateRemoteInfrastructure(framework::WorkflowSpec& workflow, std::string configurationSource);
+
+ private:
+  /// \brief Generates the mergers of a local task running on the given machines.
+  ///
+  /// If a merger would have more inputs than the fan-in of its layer, the inputs are split evenly among several
+  /// mergers, whose outputs are merged in the next layer, and so on. An input which would be alone in its merger goes
+  /// directly to the next layer. Thus the number of layers grows logarithmically with the
+  /// number of machines. The last merger is always called "<taskName>-merger" and publishes with SubSpec 0, the other
+  /// ones are called "<taskName>-merger-<layer>-<index>" and use SubSpecs above the ones of the local tasks.
+  ///
+  /// \param workflow - workflow where the mergers are added
+  /// \param taskName - name of the task
+  /// \param machines - machines running the task, the n-th one publishes with SubSpec n+1
+  /// \param fanIns - maximum number of inputs per merger for each layer, the last value is used for the next layers.
+  ///                 Empty, 0 or 1 means no limit.
+  /// \param publicationOnCompletion - whether the mergers publish as soon as all their inputs sent the next cycle,
+  ///                                  instead of periodically.
+  static void generateMergers(framework::WorkflowSpec& workflow, const std::string& taskName,
+                              const std::vector<std::string>& machines, const std::vector<size_t>& fanIns,
+                              bool publicationOnCompletion = false);
 };
 
 } // namespace core
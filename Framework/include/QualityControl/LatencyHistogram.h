@@ -0,0 +1,63 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   LatencyHistogram.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_LATENCYHISTOGRAM_H
+#define QC_CORE_LATENCYHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace o2::quality_control::core
+{
+
+/// \brief A histogram of latencies with a constant relative precision, in the manner of HdrHistogram.
+///
+/// The values below 128 are counted exactly. Above, every power of two is split in 64 buckets, which keeps the error
+/// on a percentile under 1.6% whatever the value, from microseconds to hours, in a fixed amount of memory (30 kB).
+/// Recording a value is a matter of a few instructions. The histogram is not thread safe, one is used per thread and
+/// they are added up at the end.
+class LatencyHistogram
+{
+ public:
+  LatencyHistogram();
+
+  void record(uint64_t value);
+  /// \brief Adds the values recorded in another histogram.
+  void add(const LatencyHistogram& other);
+  void reset();
+
+  uint64_t getCount() const { return mCount; }
+  uint64_t getMin() const { return mCount > 0 ? mMin : 0; }
+  uint64_t getMax() const { return mMax; }
+  double getMean() const { return mCount > 0 ? mSum / mCount : 0; }
+  /// \brief Returns the value below which the given percentage (0-100) of the recorded values are.
+  /// It is the upper bound of the bucket of that value, thus never lower than the exact percentile.
+  uint64_t getValueAtPercentile(double percentile) const;
+
+ private:
+  static size_t getIndex(uint64_t value);
+  static uint64_t getHighestEquivalentValue(size_t index);
+
+  std::vector<uint64_t> mCounts;
+  uint64_t mCount;
+  uint64_t mMin;
+  uint64_t mMax;
+  double mSum;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_LATENCYHISTOGRAM_H
@@ -0,0 +1,132 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   LocalDatabase.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_REPOSITORY_LOCALDATABASE_H
+#define QC_REPOSITORY_LOCALDATABASE_H
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+// ROOT
+#include <TBufferFile.h>
+// QC
+#include "QualityControl/DatabaseInterface.h"
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Implementation of the DatabaseInterface storing the objects in local files, without any server.
+///
+/// The serialized MonitorObjects are appended to memory-mapped segment files ("segment-<number>.dat") of the
+/// directory given as host, or as "path" in the configuration. Every version is recorded in an append-only index file
+/// ("index.dat") by its task, object name and timestamp, together with its position in the segments. The index is
+/// loaded in memory when connecting. A segment is closed when it is full ("segmentSize" bytes, 64 MB by default,
+/// unless an object is larger) and a new one is started.
+///
+/// The versions are read in place from the mapped segments, without any copy. The old versions are kept until
+/// compact() rewrites the segments with only the latest ones. The files are written by the system at its own pace,
+/// sync() forces it.
+///
+/// A directory can be opened by only one connection at a time, which holds an exclusive lock on its file "lock". The
+/// connection can be shared by several threads.
+class LocalDatabase : public DatabaseInterface
+{
+ public:
+  /// \brief A version of an object, read in place in the segment which contains it.
+  struct ObjectVersion {
+    uint64_t timestamp; // ms since epoch, when it was stored
+    const char* data;   // the serialized MonitorObject, valid until compact() or disconnect()
+    size_t size;
+  };
+
+  static constexpr size_t defaultSegmentSize = 64 * 1024 * 1024;
+
+  LocalDatabase();
+  ~LocalDatabase() override;
+
+  void connect(std::string host, std::string database, std::string username, std::string password) override;
+  void connect(const std::unordered_map<std::string, std::string>& config) override;
+  void store(std::shared_ptr<core::MonitorObject> mo) override;
+  core::MonitorObject* retrieve(std::string taskName, std::string objectName) override;
+  std::string retrieveJson(std::string taskName, std::string objectName) override;
+  void disconnect() override;
+  void prepareTaskDataContainer(std::string taskName) override;
+  std::vector<std::string> getListOfTasksWithPublications() override;
+  std::vector<std::string> getPublishedObjectNames(std::string taskName) override;
+  void truncate(std::string taskName, std::string objectName) override;
+
+  /// \brief Returns the latest version of an object, if any.
+  std::optional<ObjectVersion> getLatest(const std::string& taskName, const std::string& objectName);
+  /// \brief Returns the versions of an object stored between from and to (included), the oldest first.
+  std::vector<ObjectVersion> getHistory(const std::string& taskName, const std::string& objectName, uint64_t from = 0,
+                                        uint64_t to = std::numeric_limits<uint64_t>::max());
+  /// \brief Deserializes a version, the MonitorObject owns its encapsulated object.
+  static std::unique_ptr<core::MonitorObject> deserialize(const ObjectVersion& version);
+
+  /// \brief Rewrites the segments with only the keepVersions latest versions of each object and deletes the old ones.
+  /// The ObjectVersions obtained before are not valid anymore.
+  void compact(size_t keepVersions = 1);
+  /// \brief Writes the segments and the index to the disk.
+  void sync();
+
+ private:
+  struct Version {
+    uint64_t timestamp;
+    uint32_t segment;
+    uint64_t offset;
+    uint64_t size;
+  };
+  struct Segment {
+    char* data = nullptr;
+    size_t mapped = 0; // size of the mapping
+    size_t used = 0;   // size of the data
+    int fd = -1;       // only for the segment being written
+  };
+
+  std::string getSegmentPath(uint32_t number) const;
+  void open(const std::string& directory);
+  void loadIndex(const std::string& path);
+  /// Copies the data at the end of the segment being written, or of a new one if it does not fit.
+  Version append(const char* data, size_t size, uint64_t timestamp);
+  void startSegment(size_t capacity);
+  /// Truncates the segment being written to its data. It remains mapped for the readers.
+  void closeSegment();
+  /// Unmaps and deletes the segments from \p first on, which were written by a failed compaction.
+  void discardSegments(uint32_t first);
+  void writeIndexRecord(int fd, const std::string& taskName, const std::string& objectName, const Version& version);
+  ObjectVersion view(const Version& version) const;
+  const std::vector<Version>* findVersions(const std::string& taskName, const std::string& objectName) const;
+
+  std::string mDirectory;
+  size_t mSegmentSize;
+  std::mutex mMutex;
+  std::map<uint32_t, Segment> mSegments;
+  uint32_t mCurrentSegment; // number of the segment being written, if it is in mSegments
+  uint32_t mNextSegment;
+  int mIndexFd;
+  int mLockFd; // holds the lock of the directory
+  // task -> object -> versions, the oldest first
+  std::map<std::string, std::map<std::string, std::vector<Version>>> mIndex;
+  TBufferFile mBuffer; // reused for the serialization of all the objects
+};
+
+} // namespace o2::quality_control::repository
+
+#endif // QC_REPOSITORY_LOCALDATABASE_H
@@ -55,7 +55,8 @@ class MonitorObject : public TObject
 
   /// \brief Overwrite the TObject's method just to avoid confusion.
   ///        One should rather use getName().
-  const char* GetName() const override { return getName().c_str(); }
+  /// The returned pointer belongs to the encapsulated object, it is used by ROOT collections to find objects by name.
+  const char* GetName() const override { return mObject != nullptr ? mObject->GetName() : ""; }
 
   const std::string& getTaskName() const { return mTaskName; }
 
@@ -75,7 +76,7 @@ class MonitorObject : public TObject
 
   void setObject(TObject* object) { mObject = object; }
 
-  std::map<std::string, CheckDefinition> getChecks() const { return mChecks; }
+  const std::map<std::string, CheckDefinition>& getChecks() const { return mChecks; }
 
   bool isIsOwner() const { return mIsOwner; }
 
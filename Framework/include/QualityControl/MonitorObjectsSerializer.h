@@ -0,0 +1,87 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   MonitorObjectsSerializer.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_MONITOROBJECTSSERIALIZER_H
+#define QC_CORE_MONITOROBJECTSSERIALIZER_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+// ROOT
+#include <TBufferFile.h>
+#include <TObjArray.h>
+// O2
+#include "Framework/DataAllocator.h"
+#include "Framework/DataRef.h"
+// QC
+#include "QualityControl/MonitorObject.h"
+
+namespace o2::quality_control::core
+{
+
+/// \brief Serialization of the arrays of MonitorObjects exchanged by the QC devices.
+///
+/// The arrays are either sent with DataAllocator::snapshot(), in which case the framework serializes them as a whole
+/// and tags the message as ROOT-serialized, or serialized beforehand with serialize() and sent with send(). In the
+/// latter case, each MonitorObject is serialized separately in a single buffer, preceded by a table of the offsets of
+/// the objects, so that the receivers can deserialize only the objects they need, directly from the received message.
+/// The serializer keeps its buffer from one serialization to the next, thus it is not reallocated once it has reached
+/// the size of the largest array. It is copied into a message allocated by the framework when it is sent.
+/// The receivers use MonitorObjectsView or deserialize(), which accept both kinds of messages.
+class MonitorObjectsSerializer
+{
+ public:
+  MonitorObjectsSerializer();
+
+  /// \brief Serializes the array into the buffer of the serializer, which can then be sent with send().
+  /// \return the buffer, whose content is valid until the next serialization
+  const TBufferFile& serialize(const TObjArray& objects);
+  /// \brief Sends the array serialized last, copied into a message allocated by the framework.
+  void send(framework::DataAllocator& outputs, const framework::Output& output) const;
+  /// \brief Returns the array of MonitorObjects contained in the input, whichever the way it was serialized.
+  /// The array owns the MonitorObjects, which own the encapsulated objects.
+  static std::unique_ptr<TObjArray> deserialize(const framework::DataRef& ref);
+
+  static constexpr UInt_t magic = 0x514d4f41; // "QMOA"
+  static constexpr UInt_t version = 1;
+
+ private:
+  TBufferFile mBuffer; // reused by all the serializations, it keeps the size of the largest one
+};
+
+/// \brief Gives access to the MonitorObjects of a received message, deserializing them only when asked for.
+///
+/// Messages produced by MonitorObjectsSerializer are read in place, without copying the payload, which must thus
+/// outlive the view. The ones serialized by the framework as a whole are deserialized in the constructor.
+class MonitorObjectsView
+{
+ public:
+  explicit MonitorObjectsView(const framework::DataRef& ref);
+
+  size_t size() const;
+  /// \brief Deserializes the MonitorObject at the position index.
+  /// \return the MonitorObject, owning its encapsulated object, or nullptr if the entry is not a MonitorObject.
+  std::unique_ptr<MonitorObject> get(size_t index);
+
+ private:
+  char* mPayload = nullptr;
+  size_t mPayloadSize = 0;
+  std::vector<std::pair<ULong64_t, ULong64_t>> mOffsets; // offset and size of each object in the payload
+  std::unique_ptr<TObjArray> mArray;                     // only for the messages serialized by the framework
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_MONITOROBJECTSSERIALIZER_H
@@ -6,16 +6,31 @@
 #ifndef QC_REPOSITORY_MYSQLDATABASE_H
 #define QC_REPOSITORY_MYSQLDATABASE_H
 
-#include "Common/Timer.h"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include "QualityControl/DatabaseInterface.h"
+#include "QualityControl/ThreadPool.h"
+#include "TMessage.h"
 #include "TMySQLServer.h"
 
 class TMySQLResult;
+class TSQLStatement;
 
 namespace o2::quality_control::repository
 {
 
 /// \brief Implementation of the DatabaseInterface for MySQL
+///
+/// The objects are serialized when they are stored and written in batches by a background thread (a ThreadPool of
+/// one thread), on its own connection. A batch is written when it holds "batchSize" objects or "batchBytes" bytes,
+/// or when its first object has been waiting for "batchTime" milliseconds (configuration of the database). Each task
+/// table is written with multi-row REPLACE statements, which are prepared once and reused by all the batches. The
+/// errors of the writer are reported by flush().
 /// \todo consider storing directly the TObject, not the MonitorObject, and to put all its attributes as columns
 /// \todo handle ROOT IO streamers
 class MySqlDatabase : public DatabaseInterface
@@ -28,8 +43,31 @@ class MySqlDatabase : public DatabaseInterface
 
   void connect(std::string host, std::string database, std::string username, std::string password) override;
   void connect(const std::unordered_map<std::string, std::string>& config) override;
+  /**
+   * Serializes the object and queues it for the next batch. It blocks only if the batch is full while the previous
+   * one is still being written.
+   */
   void store(std::shared_ptr<o2::quality_control::core::MonitorObject> mo) override;
+  /**
+   * Waits until all the objects stored so far are written.
+   * \throw DatabaseException the first error met when writing the objects since the previous flush, the objects
+   *        which could not be written are lost.
+   */
+  void flush() override;
+  /**
+   * Number of objects which could not be written since the connection, because of errors of the database.
+   */
+  unsigned long getNumberOfFailedObjects();
   o2::quality_control::core::MonitorObject* retrieve(std::string taskName, std::string objectName) override;
+  /**
+   * Retrieves the objects with one query (per 1000 objects).
+   */
+  std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>>
+    retrieveMany(std::string taskName, const std::vector<std::string>& objectNames) override;
+  /**
+   * Retrieves all the objects of the task with one query.
+   */
+  std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> retrieveAll(std::string taskName) override;
   std::string retrieveJson(std::string taskName, std::string objectName) override;
   void disconnect() override;
   std::vector<std::string> getPublishedObjectNames(std::string taskName) override;
@@ -57,16 +95,70 @@ class MySqlDatabase : public DatabaseInterface
 
   void prepareTaskDataContainer(std::string taskName) override;
 
-  void storeQueue();
-  void storeForTask(std::string taskName);
+  /**
+   * \brief Selects and deserializes the given objects of a task, or all of them if objectNames is null.
+   * An object can be returned several times, e.g. for different runs.
+   */
+  std::vector<std::unique_ptr<o2::quality_control::core::MonitorObject>>
+    selectObjects(const std::string& taskName, const std::string* objectNames, size_t count);
+
+  /// The serialized objects of a task waiting to be written, one after the other in data.
+  struct TaskBatch {
+    std::vector<std::string> names;
+    std::vector<size_t> ends; // end of each object in data
+    std::vector<char> data;
+  };
+  /// The objects waiting to be written. The buffers are kept from one batch to the next.
+  struct Batch {
+    std::map<std::string, TaskBatch> tasks;
+    size_t objects = 0;
+    size_t bytes = 0;
+    std::chrono::steady_clock::time_point firstObject;
+  };
+
+  static std::string dataTableCreation(const std::string& taskName);
+  bool isFull(const Batch& batch) const;
+  /// Submitted to the writer when objects are pending. Waits until the batch is due, writes it, and submits itself
+  /// again if objects were stored in the meantime.
+  void writePending();
+  /// \return the number of objects which could not be written, error being set to the first error met
+  size_t writeBatch(Batch& batch, std::exception_ptr& error);
+  void writeTask(const std::string& taskName, const TaskBatch& objects);
+  /// The type of a blob parameter (BLOB, MEDIUM BLOB, LONG BLOB) follows the size of the data bound to it, and
+  /// cannot change from one execution of a statement to the next. The objects are written with the statements of
+  /// their size class, whose parameters are thus allocated at the size of the actual objects.
+  static int blobClass(size_t size);
+  /// Returns the cached statement inserting the given number of rows of the given blob class in the table of the
+  /// task, prepared on the connection of the writer.
+  TSQLStatement* getInsertStatement(const std::string& taskName, int blobClass, size_t rows);
+  void stopWriter();
+
+  static constexpr size_t defaultBatchSize = 5;
+  static constexpr size_t defaultBatchBytes = 8 * 1024 * 1024;
+  static constexpr std::chrono::milliseconds defaultBatchTime{ 10000 };
+  // the statements insert up to this number of rows, a batch is written with as few of them as possible
+  static constexpr size_t maxRowsPerStatement = 64;
 
   TMySQLServer* mServer;
+  TMySQLServer* mWriterServer; // used only by the writer thread, which does not share mServer with the readers
+  size_t mBatchSize;
+  size_t mBatchBytes;
+  std::chrono::milliseconds mBatchTime;
+  TMessage mMessage; // reused for the serialization of all the objects
 
-  // Queue
-  // name of tasks -> vector of mo
-  std::map<std::string, std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>>> mObjectsQueue;
-  size_t queueSize;
-  AliceO2::Common::Timer lastStorage;
+  std::mutex mMutex;
+  std::condition_variable mBatchReady;   // to the writer
+  std::condition_variable mBatchWritten; // to the callers of store and flush
+  Batch mPending;
+  Batch mWriting;      // only accessed by the writer, apart from swapping it with mPending
+  bool mWriteScheduled; // writePending is submitted or running
+  bool mFlushRequested;
+  bool mStopping;
+  unsigned long mFailedObjects;
+  std::exception_ptr mWriteError; // first error since the previous flush
+  // task name -> (blob class, number of rows) -> statement, used only by the writer thread
+  std::map<std::string, std::map<std::pair<int, size_t>, std::unique_ptr<TSQLStatement>>> mInsertStatements;
+  std::unique_ptr<core::ThreadPool> mWriter; // created at the connection
 };
 
 } // namespace o2::quality_control::repository
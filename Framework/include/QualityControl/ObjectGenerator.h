@@ -0,0 +1,83 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ObjectGenerator.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_CORE_OBJECTGENERATOR_H
+#define QC_CORE_OBJECTGENERATOR_H
+
+#include <array>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+class TObject;
+
+namespace o2::quality_control::core
+{
+
+/// \brief Builds synthetic objects of a given type, serialized size and content, for the benchmarks and the tests.
+///
+/// The size is the one of the object serialized without compression. The number of cells (bins, points or entries)
+/// which gives it is found by building two smaller objects of the same type and content and extrapolating, this is
+/// done once per type and content. The content determines how much the objects can be compressed, from nothing
+/// filled to random values. The objects are deterministic for a given seed. The histograms and the trees are not
+/// attached to any directory.
+class ObjectGenerator
+{
+ public:
+  enum class Type { TH1F, TH2F, TH3F, TProfile, TGraph, TTree };
+  enum class Content {
+    Empty,  // all the cells are 0, almost everything compresses
+    Sparse, // 1% of the cells are filled with random values
+    Smooth, // a gaussian peak at the center, without noise, as the usual distributions
+    Random  // random values everywhere, close to incompressible
+  };
+
+  explicit ObjectGenerator(unsigned int seed = 0);
+
+  /// \brief Returns an object of about sizeBytes once serialized, owned by the caller.
+  /// The difference is half a row of cells at most (half a plane for a TH3F), or it is the smallest object possible.
+  TObject* generate(Type type, const std::string& name, size_t sizeBytes, Content content = Content::Random);
+  /// \brief Returns an object with the given number of cells, owned by the caller.
+  /// The 2D and 3D histograms are made as square as possible, thus they might have slightly more or less cells.
+  TObject* generateCells(Type type, const std::string& name, size_t cells, Content content = Content::Random);
+
+  /// \brief Returns the size of the object serialized without compression.
+  static size_t getSerializedSize(const TObject& object);
+  /// \brief Returns the type of the given name (e.g. "TH2F"), throws if it does not exist.
+  static Type getType(const std::string& name);
+  /// \brief Returns the content of the given name ("empty", "sparse", "smooth" or "random").
+  /// It throws if it does not exist.
+  static Content getContent(const std::string& name);
+
+ private:
+  using Dimensions = std::array<size_t, 3>; // number of cells along each axis, only the first one for 1D objects
+
+  /// Dimensions of an object of this type with about this number of cells, under- and overflow bins included or not.
+  static Dimensions getDimensions(Type type, double cells, bool withOverflows);
+  /// Number of cells serialized, under- and overflow bins included.
+  static size_t getStoredCells(Type type, const Dimensions& dimensions);
+  TObject* build(Type type, const std::string& name, const Dimensions& dimensions, Content content);
+  /// Value of a cell at the given distance from the center of the object, the size of the object being 1.
+  double value(Content content, double distance);
+
+  std::mt19937 mGenerator;
+  // size of an object of this type and content : first + second * cells
+  std::map<std::pair<Type, Content>, std::pair<double, double>> mCalibrations;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_OBJECTGENERATOR_H
@@ -0,0 +1,94 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ObjectMerger.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_OBJECTMERGER_H
+#define QC_CORE_OBJECTMERGER_H
+
+#include <string>
+#include <unordered_map>
+// ROOT
+#include <TCollection.h>
+#include <TObject.h>
+
+class TClass;
+class TH1;
+
+namespace o2::quality_control::core
+{
+
+/// \brief Merges the ROOT objects published by the QC tasks, whatever their type.
+///
+/// The way to merge an object is resolved once for each slot (name of the object) and cached:
+///  - histograms (TH1, TH2, TH3, TProfile...) are added with addBins when possible, otherwise with TH1::Add, with
+///    TH1::Merge as a fallback when the binnings differ,
+///  - any other class providing a Merge(TCollection*) method (TGraph, TEfficiency...) is merged with it,
+///  - the other objects cannot be merged, the target is left untouched.
+/// All the updates of a slot are given at once, so that the classes merged with Merge process them in one call.
+/// The time spent merging is accumulated per class.
+class ObjectMerger
+{
+ public:
+  enum class Method { Add, Merge, None };
+
+  struct Statistics {
+    size_t merges = 0;  // number of calls to merge
+    size_t objects = 0; // number of updates merged
+    double seconds = 0;
+  };
+
+  /// \brief Merges the updates into the target, using the method cached for this slot.
+  /// \param slot - name identifying the target among the merged objects
+  /// \param target - object into which the updates are merged
+  /// \param updates - objects of the same class as the target, left untouched
+  /// \return false if the target cannot be merged, true otherwise
+  bool merge(const std::string& slot, TObject* target, TCollection& updates);
+  /// \brief Forgets the cached method of a slot, e.g. because its object was replaced by one of another class.
+  void forget(const std::string& slot) { mSlots.erase(slot); }
+
+  /// \brief Merge statistics per class name, since the last call to resetStatistics.
+  const std::unordered_map<std::string, Statistics>& getStatistics() const { return mStatistics; }
+  void resetStatistics() { mStatistics.clear(); }
+  /// \brief One line summary of the statistics, e.g. "TH1F : 12 objects in 3.2 ms, TGraph : 2 objects in 0.1 ms".
+  std::string getStatisticsSummary() const;
+
+  /// \brief Resolves how objects of the class of the target are merged.
+  static Method resolve(const TObject* target);
+  /// \brief Merges the updates into the target with the given method, without caching nor timing.
+  static bool merge(TObject* target, TCollection& updates, Method method);
+  /// \brief Adds the bins of the update to the ones of the target, if they are plain histograms (TH1F, TH2D...)
+  /// of the same class with identical fixed or variable binnings.
+  ///
+  /// The bin contents and squared weights are added as contiguous arrays, which is much faster than TH1::Add for large
+  /// histograms. The result is the same as TH1::Add, statistics included.
+  /// \return false if the histograms are not supported, in which case the target is left untouched.
+  static bool addBins(TH1* target, const TH1* update);
+  /// \brief Whether the content of the object can be emptied with reset.
+  static bool isResettable(const TObject* object);
+  /// \brief Empties the content of a merged object, so that it can be filled and merged again.
+  /// \return false if the object cannot be reset.
+  static bool reset(TObject* object);
+
+ private:
+  struct Slot {
+    TClass* objectClass;
+    Method method;
+  };
+  std::unordered_map<std::string, Slot> mSlots;
+  std::unordered_map<std::string, Statistics> mStatistics;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_OBJECTMERGER_H
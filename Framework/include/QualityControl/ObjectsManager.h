@@ -12,7 +12,9 @@
 #include <TObjArray.h>
 #include <TObjString.h>
 #include <boost/concept_check.hpp>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace o2::quality_control::core
 {
@@ -35,8 +37,10 @@ class ObjectsManager
    * Start publishing the object obj, i.e. it will be pushed forward in the workflow at regular intervals.
    * The ownership remains to the caller.
    * In most cases, objectName parameter can be ignored.
+   * The object can be looked up by its own name and by objectName, if given. If an object was already published
+   * under one of these names, the lookups with this name keep returning the first one.
    * @param obj The object to publish.
-   * @param objectName Optional, to publish something under a different name.
+   * @param objectName Optional, to look up the object under another name as well.
    */
   void startPublishing(TObject* obj, std::string objectName = "");
   // todo stoppublishing
@@ -67,9 +71,27 @@ class ObjectsManager
 
   TObjArray* getNonOwningArray() const { return new TObjArray(mMonitorObjects); };
 
+  /// \brief Returns a non-owning array with only the objects modified since the last publication.
+  ///
+  /// An object is considered modified if the checksum of its content (bin contents and errors of histograms, bin
+  /// entries of profiles, points of graphs) changed since the last call to this method or to markAllAsPublished().
+  /// Newly published objects and the objects of the other types are always considered modified.
+  TObjArray* getNonOwningArrayOfModified();
+
+  /// \brief Records the current content of all the objects as published.
+  /// It is meant to be called after a full publication (getNonOwningArray()), so that the next call to
+  /// getNonOwningArrayOfModified() compares against what was last sent.
+  void markAllAsPublished();
+
  private:
-  TObjArray mMonitorObjects;
+  /// Checksum of the content of an object, used to detect modifications.
+  /// Empty for the types which cannot be checksummed cheaply.
+  static std::optional<size_t> checksum(const TObject* object);
+
+  TObjArray mMonitorObjects;                                       // owns the MonitorObjects, in publication order
+  std::unordered_map<std::string, MonitorObject*> mMonitorObjectsIndex; // name -> MonitorObject, for the lookups
   std::string mTaskName;
+  std::unordered_map<const MonitorObject*, size_t> mPublishedChecksums; // checksums of the objects last sent
 };
 
 } // namespace o2::quality_control::core
@@ -0,0 +1,76 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   StorageDeduplicator.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_CHECKER_STORAGEDEDUPLICATOR_H
+#define QC_CHECKER_STORAGEDEDUPLICATOR_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+// QC
+#include "QualityControl/MonitorObject.h"
+
+namespace o2::quality_control::checker
+{
+
+/// \brief Tells which MonitorObjects have to be stored, skipping the ones identical to their last stored version.
+///
+/// The objects are compared by the hash and the size of their serialization, their quality included. The previous
+/// version stays valid as long as no other is stored, thus skipping the storage amounts to extending its validity. It
+/// is stored again anyway once it is older than the maximum age. A failed storage is reported with storageFailed, from
+/// any thread, so that the next version is stored even if it is identical.
+class StorageDeduplicator
+{
+ public:
+  /// The hash and the size of a serialized MonitorObject.
+  struct Content {
+    size_t hash = 0;
+    size_t size = 0;
+    bool operator==(const Content& other) const { return hash == other.hash && size == other.size; }
+  };
+
+  explicit StorageDeduplicator(std::chrono::steady_clock::duration maxAge);
+
+  /// \brief Serializes the MonitorObject and hashes the result.
+  /// It can be called concurrently, each thread serializes in its own buffer.
+  static Content hashContent(const core::MonitorObject& mo);
+
+  /// \brief Tells whether the object has to be stored, i.e. if its content changed since it was last stored or if that
+  /// version is older than the maximum age. If so, the content is recorded as the stored one, otherwise the object is
+  /// counted as deduplicated.
+  bool needsStorage(const std::string& objectName, const Content& content,
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+  /// \brief Forgets the content recorded for the object, unless another one was recorded since.
+  void storageFailed(const std::string& objectName, const Content& content);
+
+  /// \brief Number of objects which did not need to be stored.
+  unsigned long getNumberOfDeduplicated();
+
+ private:
+  struct StoredVersion {
+    Content content;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  std::chrono::steady_clock::duration mMaxAge;
+  std::mutex mMutex; // the failures can be reported by the threads of the asynchronous storage
+  std::unordered_map<std::string /*object name*/, StoredVersion> mStoredVersions;
+  unsigned long mDeduplicated = 0;
+};
+
+} // namespace o2::quality_control::checker
+
+#endif // QC_CHECKER_STORAGEDEDUPLICATOR_H
@@ -20,6 +20,10 @@ struct TaskConfig {
   std::string className;
   int cycleDurationSeconds;
   int maxNumberCycles;
+  bool deltaPublication;     // publish only the objects modified since the last cycle
+  int fullPublicationPeriod; // in delta mode, number of cycles between two publications of all the objects
+  int numberOfWorkers;       // number of threads running monitorData, 0 or 1 to run it in the main thread
+  bool backgroundPublication; // serialize the objects in a background thread
 };
 
 } // namespace o2::quality_control::core
@@ -17,7 +17,10 @@
 #include "Configuration/ConfigurationInterface.h"
 #include "Framework/DataProcessorSpec.h"
 #include "Monitoring/MonitoringFactory.h"
+// ROOT
+#include <TH1F.h>
 // QC
+#include "QualityControl/MonitorObjectsSerializer.h"
 #include "QualityControl/TaskConfig.h"
 #include "QualityControl/TaskInterface.h"
 
@@ -26,6 +29,9 @@ namespace ba = boost::accumulators;
 namespace o2::quality_control::core
 {
 
+class TaskWorkerPool;
+class BackgroundPublisher;
+
 using namespace o2::framework;
 using namespace std::chrono;
 
@@ -76,6 +82,8 @@ class TaskRunner
 
   const Inputs& getInputsSpecs() { return mInputSpecs; };
   const OutputSpec getOutputSpec() { return mMonitorObjectsSpec; };
+  /// \brief Options to be set in the DataProcessorSpec, e.g. the period of the cycle timer.
+  Options getOptions();
 
   void setResetAfterPublish(bool);
 
@@ -83,6 +91,12 @@ class TaskRunner
   static header::DataOrigin createTaskDataOrigin();
   /// \brief Unified DataDescription naming scheme for all tasks
   static header::DataDescription createTaskDataDescription(const std::string& taskName);
+  /// \brief DataDescription of the timer input of a task
+  static header::DataDescription createTimerDataDescription(const std::string& taskName);
+  /// \brief Returns true if the header is the one of the timer input of a task
+  static bool isTimerHeader(const header::DataHeader& dataHeader);
+  /// \brief Binding of the timer input which triggers the processing even if no data arrive
+  static constexpr const char* timerBinding = "timer-cycle";
 
  private:
   /// \brief Callback for CallbackService::Id::Start (DPL) a.k.a. RUN transition (FairMQ)
@@ -95,8 +109,16 @@ class TaskRunner
   void populateConfig(std::string taskName);
   void startOfActivity();
   void endOfActivity();
+  void startCycle();
   void finishCycle(DataAllocator& outputs);
   unsigned long publish(DataAllocator& outputs);
+  /// \brief Sends the objects serialized in the background, if any (background publication only).
+  void sendSerializedObjects(DataAllocator& outputs, bool wait);
+  /// \brief Output of the MonitorObjects, with the number of the cycle they belong to in a CycleHeader.
+  Output createOutput(int cycleNumber);
+  /// \brief Returns true if at least one of the data inputs (i.e. not the timer) is present.
+  bool isDataReady(InputRecord& inputs);
+  void sendDurationStatistics();
 
  private:
   std::string mTaskName;
@@ -104,8 +126,11 @@ class TaskRunner
   std::shared_ptr<configuration::ConfigurationInterface> mConfigFile; // used in init only
   std::shared_ptr<monitoring::Monitoring> mCollector;
   std::unique_ptr<TaskInterface> mTask;
+  std::unique_ptr<TaskWorkerPool> mWorkers; // only in the parallel mode
+  std::unique_ptr<BackgroundPublisher> mBackgroundPublisher; // only in the background publication mode
   bool mResetAfterPublish;
   std::shared_ptr<ObjectsManager> mObjectsManager;
+  MonitorObjectsSerializer mSerializer;
 
   // consider moving these two to TaskConfig
   Inputs mInputSpecs;
@@ -115,10 +140,19 @@ class TaskRunner
   int mLastNumberObjects;
   bool mCycleOn;
   int mCycleNumber;
+  int mBackgroundCycleNumber; // cycle of the objects serialized in the background
+
+  // cycle scheduling
+  AliceO2::Common::Timer mCycleTimer;
 
   // stats
   AliceO2::Common::Timer mStatsTimer;
   int mTotalNumberObjectsPublished;
+  std::unique_ptr<TH1F> mMonitorDataDurations;   // ms, per call of monitorData (of its dispatching in parallel mode)
+  std::unique_ptr<TH1F> mEndOfCycleDurations;    // ms, per cycle
+  std::unique_ptr<TH1F> mSerializationDurations; // ms, per cycle
+  std::unique_ptr<TH1F> mSendDurations;          // ms, per cycle, copy of the serialized objects into the message
+  double mMonitorDataDurationInCycle;            // ms, sum of monitorData calls in the current cycle
   AliceO2::Common::Timer mTimerTotalDurationActivity;
   ba::accumulator_set<double, ba::features<ba::tag::mean, ba::tag::variance>> mPCpus;
   ba::accumulator_set<double, ba::features<ba::tag::mean, ba::tag::variance>> mPMems;
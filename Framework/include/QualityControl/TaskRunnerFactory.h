@@ -6,6 +6,7 @@
 #ifndef QC_CORE_TASKFACTORY_H
 #define QC_CORE_TASKFACTORY_H
 
+#include "Framework/CompletionPolicy.h"
 #include "Framework/DataProcessorSpec.h"
 
 namespace o2::quality_control::core
@@ -26,6 +27,17 @@ class TaskRunnerFactory
   /// \param resetAfterPublish - should taskRunner reset the user's task after each MO publication
   o2::framework::DataProcessorSpec
   create(std::string taskName, std::string configurationSource, size_t id = 0, bool resetAfterPublish = false);
+
+  /// \brief Provides necessary customization of the TaskRunners.
+  ///
+  /// TaskRunners have a timer input besides their data inputs, so that they can close the cycles even if no data
+  /// arrive. They have to be invoked as soon as the data or the timer are there, thus they need a dedicated completion
+  /// policy. Call this method in the `customize` function of the workflow, before including runDataProcessing.h.
+  /// \param policies - completion policies vector
+  static void customizeInfrastructure(std::vector<framework::CompletionPolicy>& policies);
+
+  /// \brief Name of the completion policy added by customizeInfrastructure.
+  static constexpr const char* completionPolicyName = "taskRunnerCompletionPolicy";
 };
 
 } // namespace o2::quality_control::core
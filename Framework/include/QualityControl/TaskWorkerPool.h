@@ -0,0 +1,128 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TaskWorkerPool.h
+/// \author Piotr Konopka
+///
+
+#ifndef QC_CORE_TASKWORKERPOOL_H
+#define QC_CORE_TASKWORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+// O2
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/InitContext.h"
+#include "Framework/InputRoute.h"
+#include "Framework/ProcessingContext.h"
+// QC
+#include "QualityControl/Activity.h"
+#include "QualityControl/ObjectMerger.h"
+#include "QualityControl/ObjectsManager.h"
+#include "QualityControl/TaskConfig.h"
+#include "QualityControl/TaskInterface.h"
+
+namespace o2::quality_control::core
+{
+
+/// \brief Runs the monitorData of a QC task on several threads.
+///
+/// Each worker thread owns its own instance of the user's task, with its own ObjectsManager, i.e. its own copy
+/// (shard) of the published objects. Thus the user's code does not need any locking. The inputs received by the
+/// TaskRunner are copied and queued, because the ProcessingContext is not valid anymore once the callback returned.
+/// Any idle worker takes the next inputs in the queue. At the end of the cycle, the shards are merged into the objects
+/// of the main task instance, which are the ones published, and reset.
+///
+/// An exception thrown by monitorData in a worker is rethrown on the calling thread, by the next call to dispatch or by
+/// endOfCycle, so that it reaches the error handling of DPL as it does without workers. Only the first exception is
+/// kept until then, the others are logged.
+///
+/// The workers must not use the DataAllocator of the ProcessingContext they receive.
+/// Only the objects which can be merged and reset by the ObjectMerger (histograms, graphs...) are supported, the others
+/// are ignored with a warning.
+class TaskWorkerPool
+{
+ public:
+  using TaskCreator = std::function<TaskInterface*(TaskConfig&, std::shared_ptr<ObjectsManager>)>;
+
+  /// \brief Constructor
+  /// \param numberOfWorkers - number of worker threads, each running its own instance of the task
+  /// \param taskConfig - configuration of the task, used to instantiate the task's shards
+  /// \param inputSpecs - data inputs of the task, the timer ones are ignored
+  /// \param createTask - instantiates the task's shards, by default with the TaskFactory
+  TaskWorkerPool(size_t numberOfWorkers, TaskConfig& taskConfig, const framework::Inputs& inputSpecs,
+                 TaskCreator createTask = {});
+  ~TaskWorkerPool();
+
+  /// \brief Instantiates and initializes the task's shards, then starts the worker threads.
+  void initialize(framework::InitContext& iCtx);
+  /// \brief Copies the data inputs and queues them for the next idle worker.
+  /// It blocks if the queue is full, so that the memory used by the copies is bounded. It rethrows the exception of a
+  /// previous monitorData of the workers, if any, instead of queuing the inputs.
+  void dispatch(framework::ProcessingContext& pCtx);
+
+  void startOfActivity(Activity& activity);
+  void startOfCycle();
+  /// \brief Waits for the queued inputs to be processed, calls endOfCycle of the shards, merges them into the
+  /// objects of the objectsManager and resets them. It then rethrows the exception of a monitorData of the workers, if
+  /// any.
+  void endOfCycle(ObjectsManager& objectsManager);
+  void endOfActivity(Activity& activity);
+  void reset();
+
+  size_t getNumberOfWorkers() const { return mShards.size(); }
+
+ private:
+  struct Job;
+  struct Shard {
+    std::shared_ptr<ObjectsManager> objectsManager;
+    std::unique_ptr<TaskInterface> task;
+  };
+
+  void run(Shard& shard);
+  /// \brief Blocks until the queue is empty and no worker is busy.
+  void waitUntilIdle();
+  /// \brief Rethrows the first exception of the workers not rethrown yet, if any.
+  void rethrowWorkerError();
+  void merge(ObjectsManager& objectsManager);
+  /// \brief Publishes in the objectsManager an empty copy of an object published only by the shards.
+  /// \return The MonitorObject of the copy, nullptr if the object cannot be reset.
+  MonitorObject* publishCopy(ObjectsManager& objectsManager, const std::string& name, const TObject* object);
+
+  TaskConfig mTaskConfig;
+  TaskCreator mCreateTask;
+  std::vector<framework::InputRoute> mRoutes;
+  std::vector<std::unique_ptr<Shard>> mShards;
+  std::vector<std::thread> mThreads;
+  ObjectMerger mObjectMerger;
+  std::unordered_set<std::string> mNotMergeable; // names of the objects which could not be merged, warned once
+  std::vector<std::unique_ptr<TObject>> mCopies;  // objects published only by the shards, see publishCopy
+
+  std::mutex mMutex;
+  std::condition_variable mJobAvailable;
+  std::condition_variable mJobDone;
+  std::deque<std::unique_ptr<Job>> mQueue;
+  size_t mMaxQueueSize;
+  size_t mBusyWorkers;
+  bool mStopping;
+  std::exception_ptr mWorkerError; // first exception of the workers, until it is rethrown
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_TASKWORKERPOOL_H
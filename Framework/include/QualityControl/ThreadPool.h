@@ -0,0 +1,62 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ThreadPool.h
+/// \author Barthelemy von Haller
+///
+
+#ifndef QC_CORE_THREADPOOL_H
+#define QC_CORE_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace o2::quality_control::core
+{
+
+/// \brief A fixed set of threads executing the jobs submitted to it, in the order of submission.
+class ThreadPool
+{
+ public:
+  /// \param numberOfThreads - at least one thread is started
+  explicit ThreadPool(size_t numberOfThreads);
+  /// \brief Waits for the jobs already submitted to be executed, then stops the threads.
+  ~ThreadPool();
+
+  /// \brief Queues a job.
+  /// \return a future which becomes ready once the job has been executed. It rethrows the job's exception, if any.
+  std::future<void> submit(std::function<void()> job);
+
+  /// \brief Calls function(i) for i in [0, count) on the threads of the pool and waits for all the calls to be over.
+  /// The indices are distributed dynamically, so that the load is balanced. If any call throws, the first exception
+  /// is rethrown once all the threads are done.
+  void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+  size_t size() const { return mThreads.size(); }
+
+ private:
+  void run();
+
+  std::vector<std::thread> mThreads;
+  std::deque<std::packaged_task<void()>> mJobs;
+  std::mutex mMutex;
+  std::condition_variable mJobAvailable;
+  bool mStopping;
+};
+
+} // namespace o2::quality_control::core
+
+#endif // QC_CORE_THREADPOOL_H
@@ -0,0 +1,178 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   AsyncDatabaseWriter.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/AsyncDatabaseWriter.h"
+
+#include <algorithm>
+// ROOT
+#include <TROOT.h>
+// O2
+#include <Common/Exceptions.h>
+#include <FairLogger.h>
+
+using namespace AliceO2::Common;
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+namespace
+{
+/// Calls a function when leaving the scope, whichever the path.
+class ScopeExit
+{
+ public:
+  explicit ScopeExit(std::function<void()> function) : mFunction(std::move(function)) {}
+  ScopeExit(const ScopeExit&) = delete;
+  ScopeExit& operator=(const ScopeExit&) = delete;
+  ~ScopeExit() { mFunction(); }
+
+ private:
+  std::function<void()> mFunction;
+};
+} // namespace
+
+AsyncDatabaseWriter::AsyncDatabaseWriter(std::function<std::unique_ptr<DatabaseInterface>()> databaseCreator,
+                                         size_t numberOfWriters, size_t capacity, QueueFullPolicy policy)
+  : mCapacity(std::max<size_t>(capacity, 1)), mPolicy(policy), mPool(std::max<size_t>(numberOfWriters, 1))
+{
+  // the objects are streamed by the writers while the caller keeps processing others
+  ROOT::EnableThreadSafety();
+
+  for (size_t i = 0; i < mPool.size(); i++) {
+    mDatabases.push_back(databaseCreator());
+    mIdleDatabases.push_back(mDatabases.back().get());
+  }
+}
+
+AsyncDatabaseWriter::~AsyncDatabaseWriter()
+{
+  flush();
+}
+
+void AsyncDatabaseWriter::store(std::shared_ptr<MonitorObject> mo, std::function<void(bool)> onStored)
+{
+  std::string key = mo->getTaskName() + "/" + mo->getName();
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  auto pending = mPending.find(key);
+  if (pending != mPending.end()) {
+    pending->second = PendingObject{ std::move(mo), std::move(onStored) };
+    mStatistics.coalesced++;
+    return;
+  }
+
+  if (mQueue.size() >= mCapacity) {
+    if (mPolicy == QueueFullPolicy::Drop) {
+      mStatistics.dropped++;
+      lock.unlock();
+      if (onStored) {
+        onStored(false);
+      }
+      return;
+    }
+    mObjectStored.wait(lock, [this] { return mQueue.size() < mCapacity; });
+  }
+  mQueue.push_back(key);
+  mPending.emplace(std::move(key), PendingObject{ std::move(mo), std::move(onStored) });
+  schedule();
+}
+
+void AsyncDatabaseWriter::flush()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mObjectStored.wait(lock, [this] { return mQueue.empty() && mInFlight.empty(); });
+}
+
+AsyncDatabaseWriter::Statistics AsyncDatabaseWriter::getStatistics()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  Statistics statistics = mStatistics;
+  statistics.queueSize = mQueue.size();
+  return statistics;
+}
+
+AsyncDatabaseWriter::QueueFullPolicy AsyncDatabaseWriter::policyFromString(const std::string& policy)
+{
+  if (policy == "block") {
+    return QueueFullPolicy::Block;
+  } else if (policy == "drop") {
+    return QueueFullPolicy::Drop;
+  }
+  BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Unknown queue full policy : " + policy));
+}
+
+void AsyncDatabaseWriter::schedule()
+{
+  while (!mIdleDatabases.empty()) {
+    // the oldest object whose previous version is not being stored by another writer
+    auto next = std::find_if(mQueue.begin(), mQueue.end(), [this](const std::string& key) {
+      return mInFlight.count(key) == 0;
+    });
+    if (next == mQueue.end()) {
+      return;
+    }
+    std::string key = std::move(*next);
+    mQueue.erase(next);
+    auto pending = mPending.find(key);
+    PendingObject object = std::move(pending->second);
+    mPending.erase(pending);
+    mInFlight.insert(key);
+    DatabaseInterface* database = mIdleDatabases.back();
+    mIdleDatabases.pop_back();
+    mPool.submit([this, database, key = std::move(key), object = std::move(object)]() mutable {
+      write(*database, key, std::move(object));
+    });
+  }
+}
+
+void AsyncDatabaseWriter::write(DatabaseInterface& database, const std::string& key, PendingObject object)
+{
+  bool success = false;
+  // on every path, otherwise flush would wait forever and the key would never be scheduled again
+  ScopeExit releaseOnExit([&] { release(database, key, success); });
+  try {
+    database.store(object.mo);
+    success = true;
+  } catch (boost::exception& e) {
+    LOG(ERROR) << "Unable to store " << key << " : " << diagnostic_information(e);
+  } catch (std::exception& e) {
+    LOG(ERROR) << "Unable to store " << key << " : " << e.what();
+  } catch (...) {
+    LOG(ERROR) << "Unable to store " << key << " : unknown exception";
+  }
+  object.mo.reset(); // the object is released outside of the lock
+  // before the object is counted as stored, so that the callbacks are over when flush returns
+  if (object.onStored) {
+    object.onStored(success);
+  }
+}
+
+void AsyncDatabaseWriter::release(DatabaseInterface& database, const std::string& key, bool success)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mInFlight.erase(key);
+  mIdleDatabases.push_back(&database);
+  if (success) {
+    mStatistics.stored++;
+  } else {
+    mStatistics.failed++;
+  }
+  // another version of this object might be waiting for this one to be stored
+  schedule();
+  mObjectStored.notify_all();
+}
+
+} // namespace o2::quality_control::repository
@@ -0,0 +1,151 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   BackgroundPublisher.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/BackgroundPublisher.h"
+
+#include <chrono>
+// ROOT
+#include <TH1.h>
+#include <TROOT.h>
+
+using namespace o2::framework;
+using namespace std::chrono;
+
+namespace o2::quality_control::core
+{
+
+BackgroundPublisher::BackgroundPublisher()
+  : mPublications(0),
+    mSerialized(false),
+    mSerializationDuration(0),
+    mLastSerializationDuration(0),
+    mLastSendDuration(0),
+    mSerializing(false),
+    mStopping(false)
+{
+  // the objects are streamed while the task fills others
+  ROOT::EnableThreadSafety();
+  mThread = std::thread(&BackgroundPublisher::run, this);
+}
+
+BackgroundPublisher::~BackgroundPublisher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mCondition.notify_all();
+  mThread.join();
+}
+
+void BackgroundPublisher::publish(const TObjArray& objects)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCondition.wait(lock, [this] { return !mSerializing; });
+  lock.unlock();
+
+  // the background thread does not touch the back buffer until we ask it to serialize it
+  auto array = std::make_unique<TObjArray>();
+  array->SetOwner(true);
+  mPublications++;
+  for (const auto& object : objects) {
+    auto* mo = dynamic_cast<MonitorObject*>(object);
+    if (mo == nullptr || mo->getObject() == nullptr) {
+      continue;
+    }
+    auto* copy = new MonitorObject(*mo); // only the metadata, the encapsulated object is shared at this point
+    auto& backObject = mBackObjects[mo->getName()];
+    backObject.publication = mPublications;
+    copyToBackBuffer(mo->getObject(), backObject.copy);
+    copy->setObject(backObject.copy.get());
+    copy->setIsOwner(false);
+    array->Add(copy);
+  }
+  // the copies of the objects not published anymore are deleted
+  for (auto backObject = mBackObjects.begin(); backObject != mBackObjects.end();) {
+    if (backObject->second.publication != mPublications) {
+      backObject = mBackObjects.erase(backObject);
+    } else {
+      ++backObject;
+    }
+  }
+
+  lock.lock();
+  // the buffer of the serializer is reused, a message not sent yet is lost
+  mSerialized = false;
+  mToSerialize = std::move(array);
+  mSerializing = true;
+  lock.unlock();
+  mCondition.notify_all();
+}
+
+bool BackgroundPublisher::send(DataAllocator& outputs, const Output& output, bool wait)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (wait) {
+    mCondition.wait(lock, [this] { return !mSerializing; });
+  }
+  if (!mSerialized) {
+    return false;
+  }
+  // under the lock, the background thread does not serialize anything before the message is copied
+  auto start = steady_clock::now();
+  mSerializer.send(outputs, output);
+  mLastSendDuration = duration_cast<duration<double, std::milli>>(steady_clock::now() - start).count();
+  mSerialized = false;
+  mLastSerializationDuration = mSerializationDuration;
+  return true;
+}
+
+void BackgroundPublisher::run()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    mCondition.wait(lock, [this] { return mStopping || mToSerialize; });
+    if (mStopping) {
+      return;
+    }
+    auto array = std::move(mToSerialize);
+    lock.unlock();
+
+    auto start = steady_clock::now();
+    mSerializer.serialize(*array);
+    double elapsed = duration_cast<duration<double, std::milli>>(steady_clock::now() - start).count();
+    array.reset();
+
+    lock.lock();
+    mSerialized = true;
+    mSerializationDuration = elapsed;
+    mSerializing = false;
+    mCondition.notify_all();
+  }
+}
+
+void BackgroundPublisher::copyToBackBuffer(const TObject* object, std::unique_ptr<TObject>& copy)
+{
+  auto* histo = dynamic_cast<const TH1*>(object);
+  if (histo != nullptr && copy && copy->IsA() == object->IsA()) {
+    // TH1::Copy reuses the arrays of the copy if they have the right size
+    histo->Copy(*copy);
+    static_cast<TH1*>(copy.get())->SetDirectory(nullptr);
+  } else {
+    copy.reset(object->Clone());
+    if (auto* histoCopy = dynamic_cast<TH1*>(copy.get())) {
+      histoCopy->SetDirectory(nullptr);
+    }
+  }
+}
+
+} // namespace o2::quality_control::core
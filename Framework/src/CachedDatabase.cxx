@@ -0,0 +1,311 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CachedDatabase.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/CachedDatabase.h"
+
+// ROOT
+#include <TBufferFile.h>
+#include <TBufferJSON.h>
+// QC
+#include "QualityControl/MonitorObject.h"
+
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+CachedDatabase::CachedDatabase(std::unique_ptr<DatabaseInterface> database, size_t memoryBudget,
+                               std::chrono::milliseconds timeToLive)
+  : mDatabase(std::move(database)), mMemoryBudget(memoryBudget), mTimeToLive(timeToLive), mStorages(1)
+{
+}
+
+void CachedDatabase::connect(std::string host, std::string database, std::string username, std::string password)
+{
+  clear();
+  mDatabase->connect(host, database, username, password);
+}
+
+void CachedDatabase::connect(const std::unordered_map<std::string, std::string>& config)
+{
+  if (config.count("cacheMemoryBudget")) {
+    mMemoryBudget = std::stoul(config.at("cacheMemoryBudget")) * 1024 * 1024;
+  }
+  if (config.count("cacheTimeToLive")) {
+    mTimeToLive = std::chrono::milliseconds(std::stol(config.at("cacheTimeToLive")));
+  }
+  clear();
+  mDatabase->connect(config);
+}
+
+void CachedDatabase::store(std::shared_ptr<MonitorObject> mo)
+{
+  mDatabase->store(mo);
+  invalidate(mo->getTaskName(), mo->getName());
+}
+
+std::future<void> CachedDatabase::storeAsync(std::shared_ptr<MonitorObject> mo)
+{
+  invalidate(mo->getTaskName(), mo->getName());
+  auto stored = std::make_shared<std::future<void>>(mDatabase->storeAsync(mo));
+  return mStorages.submit([this, stored, taskName = mo->getTaskName(), objectName = mo->getName()] {
+    // a read made before the end of the storage might have cached the previous version again
+    try {
+      stored->get();
+    } catch (...) {
+      invalidate(taskName, objectName);
+      throw;
+    }
+    invalidate(taskName, objectName);
+  });
+}
+
+void CachedDatabase::flush() { mDatabase->flush(); }
+
+MonitorObject* CachedDatabase::retrieve(std::string taskName, std::string objectName)
+{
+  auto objectKey = key(taskName, objectName);
+  uint64_t version;
+  if (auto cached = lookup(objectKey, version)) {
+    return copy(*cached);
+  }
+
+  auto fetched = fetch(taskName, objectName);
+  if (fetched == nullptr) {
+    return nullptr;
+  }
+  insert(objectKey, version, fetched);
+  return copy(*fetched);
+}
+
+std::vector<std::shared_ptr<MonitorObject>> CachedDatabase::retrieveMany(std::string taskName,
+                                                                         const std::vector<std::string>& objectNames)
+{
+  std::vector<std::shared_ptr<const MonitorObject>> found(objectNames.size());
+  std::vector<std::string> missing;
+  std::unordered_map<std::string, uint64_t> missingVersions;
+  for (size_t i = 0; i < objectNames.size(); i++) {
+    uint64_t version;
+    found[i] = lookup(key(taskName, objectNames[i]), version);
+    if (found[i] == nullptr && missingVersions.emplace(objectNames[i], version).second) {
+      missing.push_back(objectNames[i]);
+    }
+  }
+
+  if (!missing.empty()) {
+    // the objects not found are not returned, thus they are matched to the requested ones by their names
+    std::unordered_map<std::string, std::shared_ptr<const MonitorObject>> fetched;
+    for (auto& mo : mDatabase->retrieveMany(taskName, missing)) {
+      auto name = mo->getName();
+      if (auto version = missingVersions.find(name); version != missingVersions.end()) {
+        insert(key(taskName, name), version->second, mo);
+        fetched.emplace(name, std::move(mo));
+      }
+    }
+    for (size_t i = 0; i < objectNames.size(); i++) {
+      if (found[i] == nullptr) {
+        if (auto mo = fetched.find(objectNames[i]); mo != fetched.end()) {
+          found[i] = mo->second;
+        }
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<MonitorObject>> objects;
+  for (const auto& mo : found) {
+    if (mo != nullptr) {
+      objects.emplace_back(copy(*mo));
+    }
+  }
+  return objects;
+}
+
+std::string CachedDatabase::retrieveJson(std::string taskName, std::string objectName)
+{
+  auto objectKey = key(taskName, objectName);
+  uint64_t version;
+  std::shared_ptr<const std::string> json;
+  auto object = lookup(objectKey, version, &json);
+  if (json != nullptr) {
+    return *json;
+  }
+
+  if (object == nullptr) {
+    // Rather than the JSON of the database, we take the object, which is cached as well.
+    object = fetch(taskName, objectName);
+    if (object == nullptr) {
+      return std::string();
+    }
+    insert(objectKey, version, object);
+  }
+  json = std::make_shared<const std::string>(TBufferJSON::ConvertToJSON(object->getObject()).Data());
+  insertJson(objectKey, object, json);
+  return *json;
+}
+
+void CachedDatabase::disconnect()
+{
+  mDatabase->disconnect();
+}
+
+void CachedDatabase::prepareTaskDataContainer(std::string taskName)
+{
+  mDatabase->prepareTaskDataContainer(taskName);
+}
+
+std::vector<std::string> CachedDatabase::getListOfTasksWithPublications()
+{
+  return mDatabase->getListOfTasksWithPublications();
+}
+
+std::vector<std::string> CachedDatabase::getPublishedObjectNames(std::string taskName)
+{
+  return mDatabase->getPublishedObjectNames(taskName);
+}
+
+void CachedDatabase::truncate(std::string taskName, std::string objectName)
+{
+  mDatabase->truncate(taskName, objectName);
+  invalidate(taskName, objectName);
+}
+
+void CachedDatabase::invalidate(const std::string& taskName, const std::string& objectName)
+{
+  auto objectKey = key(taskName, objectName);
+  std::lock_guard<std::mutex> lock(mMutex);
+  mVersions[objectKey]++;
+  if (auto entry = mEntries.find(objectKey); entry != mEntries.end()) {
+    erase(entry);
+  }
+}
+
+void CachedDatabase::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEntries.clear();
+  mLru.clear();
+  mStatistics.bytes = 0;
+}
+
+CachedDatabase::Statistics CachedDatabase::getStatistics()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStatistics.entries = mEntries.size();
+  return mStatistics;
+}
+
+std::string CachedDatabase::key(const std::string& taskName, const std::string& objectName)
+{
+  return taskName + "/" + objectName;
+}
+
+size_t CachedDatabase::estimateSize(const MonitorObject& object)
+{
+  TBufferFile buffer(TBuffer::kWrite);
+  buffer.WriteObject(&object);
+  return buffer.Length();
+}
+
+MonitorObject* CachedDatabase::copy(const MonitorObject& object)
+{
+  // a deep copy, the encapsulated object is cloned as well
+  auto* mo = dynamic_cast<MonitorObject*>(object.Clone());
+  mo->setIsOwner(true); // the clone of the object is not referenced by anything else
+  return mo;
+}
+
+std::shared_ptr<const MonitorObject> CachedDatabase::fetch(const std::string& taskName, const std::string& objectName)
+{
+  // the databases return the objects as streamed by the tasks, without the ownership of the object they wrap
+  MonitorObject* mo = mDatabase->retrieve(taskName, objectName);
+  if (mo != nullptr) {
+    mo->setIsOwner(true);
+  }
+  return std::shared_ptr<const MonitorObject>(mo);
+}
+
+std::shared_ptr<const MonitorObject> CachedDatabase::lookup(const std::string& key, uint64_t& version,
+                                                            std::shared_ptr<const std::string>* json)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto currentVersion = mVersions.find(key);
+  version = currentVersion != mVersions.end() ? currentVersion->second : 0;
+
+  auto entry = mEntries.find(key);
+  if (entry != mEntries.end() && mTimeToLive.count() > 0 && Clock::now() - entry->second.fetched > mTimeToLive) {
+    erase(entry);
+    entry = mEntries.end();
+    mStatistics.expirations++;
+  }
+  if (entry == mEntries.end()) {
+    mStatistics.misses++;
+    return nullptr;
+  }
+
+  mStatistics.hits++;
+  mLru.splice(mLru.begin(), mLru, entry->second.lruPosition);
+  if (json != nullptr) {
+    *json = entry->second.json;
+  }
+  return entry->second.object;
+}
+
+void CachedDatabase::insert(const std::string& key, uint64_t version, std::shared_ptr<const MonitorObject> object)
+{
+  size_t size = estimateSize(*object);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto currentVersion = mVersions.find(key);
+  if ((currentVersion != mVersions.end() ? currentVersion->second : 0) != version || size > mMemoryBudget) {
+    return; // stored or truncated in the meantime, or too large
+  }
+  if (auto entry = mEntries.find(key); entry != mEntries.end()) {
+    erase(entry);
+  }
+  mLru.push_front(key);
+  mEntries.emplace(key, Entry{ std::move(object), nullptr, size, Clock::now(), mLru.begin() });
+  mStatistics.bytes += size;
+  evict();
+}
+
+void CachedDatabase::insertJson(const std::string& key, const std::shared_ptr<const MonitorObject>& object,
+                                std::shared_ptr<const std::string> json)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto entry = mEntries.find(key);
+  if (entry == mEntries.end() || entry->second.object != object || entry->second.json != nullptr) {
+    return; // not the same version anymore
+  }
+  mStatistics.bytes += json->size();
+  entry->second.json = std::move(json);
+  evict();
+}
+
+void CachedDatabase::erase(std::unordered_map<std::string, Entry>::iterator entry)
+{
+  mStatistics.bytes -= entry->second.objectSize + (entry->second.json ? entry->second.json->size() : 0);
+  mLru.erase(entry->second.lruPosition);
+  mEntries.erase(entry);
+}
+
+void CachedDatabase::evict()
+{
+  while (mStatistics.bytes > mMemoryBudget && !mLru.empty()) {
+    erase(mEntries.find(mLru.back()));
+    mStatistics.evictions++;
+  }
+}
+
+} // namespace o2::quality_control::repository
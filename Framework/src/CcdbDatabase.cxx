@@ -16,9 +16,12 @@
 #include "QualityControl/CcdbDatabase.h"
 #include "Common/Exceptions.h"
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 #include "TBufferJSON.h"
+#include "TMessage.h"
+#include "TROOT.h"
 
 using namespace std::chrono;
 using namespace AliceO2::Common;
@@ -28,7 +31,11 @@ namespace o2::quality_control::repository
 
 using namespace std;
 
-CcdbDatabase::CcdbDatabase() : mUrl("") {}
+CcdbDatabase::CcdbDatabase() : mUrl("")
+{
+  // the objects are deserialized concurrently by retrieveMany
+  ROOT::EnableThreadSafety();
+}
 
 CcdbDatabase::~CcdbDatabase() { disconnect(); }
 
@@ -36,16 +43,42 @@ void CcdbDatabase::connect(std::string host, std::string database, std::string u
 {
   mUrl = host;
   ccdbApi.init(mUrl);
+  mUploader = std::make_unique<CcdbUploader>(defaultUploadConnections, 4 * defaultUploadConnections);
+  createFetchers(defaultFetchConnections);
 }
 
 void CcdbDatabase::connect(const std::unordered_map<std::string, std::string>& config)
 {
   mUrl = config.at("host");
   ccdbApi.init(mUrl);
+  size_t uploadConnections = config.count("uploadConnections") ? std::stoul(config.at("uploadConnections"))
+                                                               : defaultUploadConnections;
+  mUploader = std::make_unique<CcdbUploader>(uploadConnections, 4 * uploadConnections);
+  createFetchers(config.count("fetchConnections") ? std::stoul(config.at("fetchConnections"))
+                                                  : defaultFetchConnections);
+}
+
+void CcdbDatabase::createFetchers(size_t fetchConnections)
+{
+  mFetchers = std::make_unique<core::ThreadPool>(std::max<size_t>(fetchConnections, 1));
+  mFetchApis.clear();
+  for (size_t i = 0; i < mFetchers->size(); i++) {
+    mFetchApis.push_back(std::make_unique<o2::ccdb::CcdbApi>());
+    mFetchApis.back()->init(mUrl);
+  }
 }
 
 void CcdbDatabase::store(std::shared_ptr<o2::quality_control::core::MonitorObject> mo)
 {
+  storeAsync(mo).get();
+}
+
+std::future<void> CcdbDatabase::storeAsync(std::shared_ptr<o2::quality_control::core::MonitorObject> mo)
+{
+  if (!mUploader) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the CCDB. Do not store."));
+  }
+
   if (mo->getName().length() == 0 || mo->getTaskName().length() == 0) {
     BOOST_THROW_EXCEPTION(DatabaseException()
                           << errinfo_details("Object and task names can't be empty. Do not store."));
@@ -62,8 +95,21 @@ void CcdbDatabase::store(std::shared_ptr<o2::quality_control::core::MonitorObjec
   long from = getCurrentTimestamp();
   long to = getFutureTimestamp(60 * 60 * 24 * 365 * 10); // todo set a proper timestamp for the end
 
-  cout << "storing : " << path << endl;
-  ccdbApi.store(mo.get(), path, metadata, from, to);
+  // same request as CcdbApi::store, but the object is serialized here and uploaded by the pool of connections
+  auto message = std::make_unique<TMessage>(kMESS_OBJECT);
+  message->WriteObjectAny(mo.get(), mo->IsA());
+
+  return mUploader->upload(getStorageUrl(mUrl, path, metadata, from, to), mo->GetName(), std::move(message));
+}
+
+std::string CcdbDatabase::getStorageUrl(const std::string& host, const std::string& path,
+                                        const std::map<std::string, std::string>& metadata, long from, long to)
+{
+  string url = host + "/" + path + "/" + std::to_string(from) + "/" + std::to_string(to) + "/";
+  for (const auto& [key, value] : metadata) {
+    url += key + "=" + value + "/";
+  }
+  return url;
 }
 
 /**
@@ -76,14 +122,42 @@ struct MemoryStruct {
 
 core::MonitorObject* CcdbDatabase::retrieve(std::string taskName, std::string objectName)
 {
+  std::lock_guard<std::mutex> lock(mApiMutex);
+  return retrieve(ccdbApi, taskName, objectName);
+}
 
+core::MonitorObject* CcdbDatabase::retrieve(o2::ccdb::CcdbApi& api, const std::string& taskName,
+                                            const std::string& objectName)
+{
   string path = taskName + "/" + objectName;
   map<string, string> metadata;
 
-  TObject* object = ccdbApi.retrieve(path, metadata, getCurrentTimestamp());
+  TObject* object = api.retrieve(path, metadata, getCurrentTimestamp());
   return dynamic_cast<core::MonitorObject*>(object);
 }
 
+std::vector<std::shared_ptr<core::MonitorObject>> CcdbDatabase::retrieveMany(std::string taskName,
+                                                                           const std::vector<std::string>& objectNames)
+{
+  if (!mFetchers) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the CCDB. Do not retrieve."));
+  }
+
+  // each job has its own CcdbApi and retrieves every n-th object
+  std::vector<std::shared_ptr<core::MonitorObject>> objects(objectNames.size());
+  size_t jobs = std::min(mFetchApis.size(), objectNames.size());
+  mFetchers->parallelFor(jobs, [&](size_t job) {
+    for (size_t i = job; i < objectNames.size(); i += jobs) {
+      objects[i].reset(retrieve(*mFetchApis[job], taskName, objectNames[i]));
+      if (objects[i]) {
+        objects[i]->setIsOwner(true); // the task streamed it without the ownership
+      }
+    }
+  });
+  objects.erase(std::remove(objects.begin(), objects.end(), nullptr), objects.end());
+  return objects;
+}
+
 std::string CcdbDatabase::retrieveJson(std::string taskName, std::string objectName)
 {
   std::unique_ptr<core::MonitorObject> monitor(retrieve(taskName, objectName));
@@ -108,6 +182,7 @@ void CcdbDatabase::prepareTaskDataContainer(std::string taskName)
 
 std::string CcdbDatabase::getListing(std::string path, std::string accept)
 {
+  std::lock_guard<std::mutex> lock(mApiMutex);
   std::string tempString = ccdbApi.list(path, false, accept);
 
   return tempString;
@@ -152,7 +227,11 @@ std::vector<std::string> CcdbDatabase::getPublishedObjectNames(std::string taskN
 {
   std::vector<string> result;
 
-  string listing = ccdbApi.list(taskName + "/.*", true, "Application/JSON");
+  string listing;
+  {
+    std::lock_guard<std::mutex> lock(mApiMutex);
+    listing = ccdbApi.list(taskName + "/.*", true, "Application/JSON");
+  }
 
   // Split the string we received, by line. Also trim it and remove empty lines. Select the lines starting with "path".
   std::stringstream ss(listing);
@@ -193,6 +272,7 @@ void CcdbDatabase::truncate(std::string taskName, std::string objectName)
 {
   cout << "truncating data for " << taskName << "/" << objectName << endl;
 
+  std::lock_guard<std::mutex> lock(mApiMutex);
   ccdbApi.truncate(taskName + "/" + objectName);
 }
 
@@ -0,0 +1,176 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CcdbUploader.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/CcdbUploader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <curl/curl.h>
+// ROOT
+#include <TMessage.h>
+// O2
+#include "Common/Exceptions.h"
+
+using namespace AliceO2::Common;
+
+namespace o2::quality_control::repository
+{
+
+namespace
+{
+
+/// The body of a request, read by curl directly from the buffer of the TMessage, without any copy.
+struct Body {
+  const char* data;
+  size_t size;
+  size_t position;
+};
+
+size_t readBody(char* buffer, size_t size, size_t count, void* argument)
+{
+  auto* body = static_cast<Body*>(argument);
+  size_t length = std::min(size * count, body->size - body->position);
+  std::memcpy(buffer, body->data + body->position, length);
+  body->position += length;
+  return length;
+}
+
+int seekBody(void* argument, curl_off_t offset, int origin)
+{
+  auto* body = static_cast<Body*>(argument);
+  if (origin != SEEK_SET || offset < 0 || static_cast<size_t>(offset) > body->size) {
+    return CURL_SEEKFUNC_CANTSEEK;
+  }
+  body->position = static_cast<size_t>(offset);
+  return CURL_SEEKFUNC_OK;
+}
+
+size_t discardResponse(char*, size_t size, size_t count, void*) { return size * count; }
+
+} // namespace
+
+CcdbUploader::CcdbUploader(size_t numberOfConnections, size_t capacity)
+  : mHeaders(nullptr),
+    mCapacity(std::max<size_t>(capacity, 1)),
+    mInFlight(0),
+    mPool(std::max<size_t>(numberOfConnections, 1))
+{
+  // curl_global_init is not thread safe and must be called once per process, before any other curl call
+  static std::once_flag curlInitialized;
+  std::call_once(curlInitialized, []() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    std::atexit(curl_global_cleanup);
+  });
+
+  // no "Expect: 100-continue", it would cost one more round trip for each large object
+  mHeaders = curl_slist_append(nullptr, "Expect:");
+  for (size_t i = 0; i < mPool.size(); i++) {
+    // The handles are kept for all the uploads, so that their connections are reused.
+    CURL* curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, mHeaders);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discardResponse);
+    mHandles.push_back(curl);
+    mIdleHandles.push_back(curl);
+  }
+}
+
+CcdbUploader::~CcdbUploader()
+{
+  flush();
+  for (CURL* curl : mHandles) {
+    curl_easy_cleanup(curl);
+  }
+  curl_slist_free_all(mHeaders);
+}
+
+std::future<void> CcdbUploader::upload(std::string url, std::string fileName, std::unique_ptr<TMessage> message)
+{
+  Upload upload{ std::move(url), std::move(fileName), std::move(message), std::promise<void>() };
+  std::future<void> future = upload.promise.get_future();
+  std::unique_lock<std::mutex> lock(mMutex);
+  mUploadDone.wait(lock, [this] { return mQueue.size() < mCapacity; });
+  mQueue.push_back(std::move(upload));
+  schedule();
+  return future;
+}
+
+void CcdbUploader::flush()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mUploadDone.wait(lock, [this] { return mQueue.empty() && mInFlight == 0; });
+}
+
+void CcdbUploader::schedule()
+{
+  while (!mIdleHandles.empty() && !mQueue.empty()) {
+    CURL* curl = mIdleHandles.back();
+    mIdleHandles.pop_back();
+    // the promise can't be copied into the std::function of the job, the upload is thus shared
+    auto upload = std::make_shared<Upload>(std::move(mQueue.front()));
+    mQueue.pop_front();
+    mInFlight++;
+    mPool.submit([this, curl, upload]() {
+      perform(curl, *upload);
+      std::lock_guard<std::mutex> lock(mMutex);
+      mInFlight--;
+      mIdleHandles.push_back(curl);
+      schedule();
+      mUploadDone.notify_all();
+    });
+  }
+  // room in the queue
+  mUploadDone.notify_all();
+}
+
+void CcdbUploader::perform(CURL* curl, Upload& upload)
+{
+  Body body{ upload.message->Buffer(), static_cast<size_t>(upload.message->Length()), 0 };
+  curl_mime* form = curl_mime_init(curl);
+  curl_mimepart* part = curl_mime_addpart(form);
+  curl_mime_name(part, "send");
+  curl_mime_filename(part, upload.fileName.c_str());
+  curl_mime_data_cb(part, body.size, readBody, seekBody, nullptr, &body);
+  curl_easy_setopt(curl, CURLOPT_URL, upload.url.c_str());
+  curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
+
+  CURLcode result = curl_easy_perform(curl);
+  long httpCode = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+  curl_easy_setopt(curl, CURLOPT_MIMEPOST, static_cast<curl_mime*>(nullptr));
+  curl_mime_free(form);
+
+  try {
+    if (result != CURLE_OK) {
+      BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Upload to " + upload.url + " failed : " +
+                                                                   curl_easy_strerror(result)));
+    }
+    if (httpCode < 200 || httpCode >= 300) {
+      BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Upload to " + upload.url +
+                                                                   " failed with HTTP code " +
+                                                                   std::to_string(httpCode)));
+    }
+    upload.promise.set_value();
+  } catch (...) {
+    upload.promise.set_exception(std::current_exception());
+  }
+  upload.message.reset(); // released before the upload is considered done
+}
+
+} // namespace o2::quality_control::repository
@@ -9,6 +9,7 @@
 // ROOT
 #include <TClass.h>
 #include <TMessage.h>
+#include <TROOT.h>
 #include <TSystem.h>
 // O2
 #include <Common/Exceptions.h>
@@ -17,6 +18,7 @@
 #include <TMap.h>
 // QC
 #include "QualityControl/DatabaseFactory.h"
+#include "QualityControl/MonitorObjectsSerializer.h"
 #include "QualityControl/TaskRunner.h"
 
 using namespace std::chrono;
@@ -47,6 +49,15 @@ Checker::Checker(std::string checkerName, std::string taskName, std::string conf
 
 Checker::~Checker()
 {
+  // the objects still in the queue are stored before the final metrics are computed
+  if (mDatabaseWriter) {
+    mDatabaseWriter->flush();
+  }
+  if (mCollector) {
+    sendStorageStatistics();
+  }
+  mDatabaseWriter.reset();
+
   // Monitoring
   if (mCollector) {
     std::chrono::duration<double> diff = endLastObject - startFirstObject;
@@ -63,11 +74,43 @@ void Checker::init(framework::InitContext&)
   try {
     std::unique_ptr<ConfigurationInterface> config = ConfigurationFactory::getConfiguration(mConfigurationSource);
     // configuration of the database
-    mDatabase = DatabaseFactory::create(config->get<std::string>("qc.config.database.implementation"));
-    mDatabase->connect(config->getRecursiveMap("qc.config.database"));
+    auto databaseImplementation = config->get<std::string>("qc.config.database.implementation");
+    auto databaseConfig = config->getRecursiveMap("qc.config.database");
+    mDatabase = DatabaseFactory::create(databaseImplementation);
+    mDatabase->connect(databaseConfig);
     LOG(INFO) << "Database that is going to be used : ";
-    LOG(INFO) << ">> Implementation : " << config->get<std::string>("qc.config.database.implementation");
+    LOG(INFO) << ">> Implementation : " << databaseImplementation;
     LOG(INFO) << ">> Host : " << config->get<std::string>("qc.config.database.host");
+    // asynchronous storage, each writer has its own connection
+    auto numberOfWriters = config->get<int>("qc.config.checker.numberOfWriters", 0);
+    LOG(INFO) << ">> Number of writers : " << numberOfWriters << (numberOfWriters > 0 ? "" : " (synchronous storage)");
+    if (numberOfWriters > 0) {
+      auto queueSize = config->get<int>("qc.config.checker.storageQueueSize", 1000);
+      auto policy = config->get<std::string>("qc.config.checker.storageQueueFullPolicy", "block");
+      LOG(INFO) << ">> Storage queue size : " << queueSize << ", when full : " << policy;
+      mDatabaseWriter = std::make_unique<AsyncDatabaseWriter>(
+        [databaseImplementation, databaseConfig]() {
+          auto database = DatabaseFactory::create(databaseImplementation);
+          database->connect(databaseConfig);
+          return database;
+        },
+        numberOfWriters, queueSize, AsyncDatabaseWriter::policyFromString(policy));
+    }
+    // deduplication of the storage
+    bool deduplication = config->get<std::string>("qc.config.checker.storageDeduplication", "false") == "true";
+    auto deduplicationMaxAge = config->get<int>("qc.config.checker.storageDeduplicationMaxAge", 600);
+    LOG(INFO) << ">> Storage deduplication : " << deduplication
+              << (deduplication ? ", max age " + std::to_string(deduplicationMaxAge) + " s" : "");
+    if (deduplication) {
+      mDeduplicator = std::make_unique<StorageDeduplicator>(std::chrono::seconds(deduplicationMaxAge));
+    }
+    // checks execution
+    auto numberOfThreads = config->get<int>("qc.config.checker.numberOfThreads", 1);
+    LOG(INFO) << "Number of threads running the checks : " << numberOfThreads;
+    if (numberOfThreads > 1) {
+      ROOT::EnableThreadSafety(); // the checks beautify the objects concurrently
+      mThreadPool = std::make_unique<ThreadPool>(numberOfThreads);
+    }
   } catch (
     std::string const& e) { // we have to catch here to print the exception because the device will make it disappear
     LOG(ERROR) << "exception : " << e;
@@ -100,24 +143,59 @@ void Checker::run(framework::ProcessingContext& ctx)
     startFirstObject = system_clock::now();
   }
 
-  std::shared_ptr<TObjArray> moArray{ std::move(framework::DataRefUtils::as<TObjArray>(*ctx.inputs().begin())) };
-  moArray->SetOwner(false);
-  auto checkedMoArray = std::make_unique<TObjArray>();
-  checkedMoArray->SetOwner();
-
-  for (const auto& to : *moArray) {
-    std::shared_ptr<MonitorObject> mo{dynamic_cast<MonitorObject*>(to)};
-    moArray->RemoveFirst();
+  // The objects are deserialized one by one, directly from the received message, and their checks instantiated.
+  MonitorObjectsView objects(*ctx.inputs().begin());
+  std::vector<std::shared_ptr<MonitorObject>> checkedObjects;
+  std::vector<std::shared_ptr<const CheckPlan>> plans;
+  checkedObjects.reserve(objects.size());
+  plans.reserve(objects.size());
+  for (size_t i = 0; i < objects.size(); i++) {
+    std::shared_ptr<MonitorObject> mo{ objects.get(i) };
     if (mo) {
-      check(mo);
-      store(mo);
-      mTotalNumberHistosReceived++;
-      checkedMoArray->Add(new MonitorObject(*mo));
+      plans.push_back(resolveChecks(*mo));
+      checkedObjects.push_back(std::move(mo));
     } else {
       mLogger << "the mo is null" << AliceO2::InfoLogger::InfoLogger::endm;
     }
   }
 
+  // The checks of different objects are independent, thus they can run in parallel. The results are kept by index, so
+  // that the logs, the storage and the output follow the order of reception whatever the number of threads.
+  // The objects are hashed there as well if the storage is deduplicated, since it implies serializing them.
+  std::vector<std::vector<Quality>> results(checkedObjects.size());
+  std::vector<StorageDeduplicator::Content> contents(checkedObjects.size());
+  auto runChecks = [&](size_t i) {
+    results[i] = check(checkedObjects[i], plans[i]->checks);
+    if (mDeduplicator) {
+      contents[i] = StorageDeduplicator::hashContent(*checkedObjects[i]);
+    }
+  };
+  if (mThreadPool) {
+    mThreadPool->parallelFor(checkedObjects.size(), runChecks);
+  } else {
+    for (size_t i = 0; i < checkedObjects.size(); i++) {
+      runChecks(i);
+    }
+  }
+
+  auto checkedMoArray = std::make_unique<TObjArray>(); // does not own the objects, they are kept by checkedObjects
+  for (size_t i = 0; i < checkedObjects.size(); i++) {
+    auto& mo = checkedObjects[i];
+    const auto& checks = plans[i]->checks;
+    if (!checks.empty()) {
+      mLogger << "Checked \"" << mo->getName() << "\" :";
+      for (size_t c = 0; c < checks.size(); c++) {
+        mLogger << " " << checks[c].first << "=" << results[i][c].getName();
+      }
+      mLogger << AliceO2::InfoLogger::InfoLogger::endm;
+    }
+    if (!mDeduplicator || mDeduplicator->needsStorage(mo->getName(), contents[i])) {
+      store(mo, contents[i]);
+    }
+    mTotalNumberHistosReceived++;
+    checkedMoArray->Add(mo.get());
+  }
+
   send(checkedMoArray, ctx.outputs());
 
   // monitoring
@@ -127,6 +205,7 @@ void Checker::run(framework::ProcessingContext& ctx)
   if (timer.isTimeout()) {
     timer.reset(1000000); // 10 s.
     mCollector->send({ mTotalNumberHistosReceived, "objects" }, o2::monitoring::DerivedMetricMode::RATE);
+    sendStorageStatistics();
   }
 }
 
@@ -137,40 +216,86 @@ o2::header::DataDescription Checker::createCheckerDataDescription(const std::str
   return description;
 }
 
-void Checker::check(std::shared_ptr<MonitorObject> mo)
+static bool sameDefinitions(const std::vector<CheckDefinition>& planDefinitions,
+                            const std::map<std::string, CheckDefinition>& definitions)
 {
-  std::map<std::string /*checkName*/, CheckDefinition> checks = mo->getChecks();
+  if (planDefinitions.size() != definitions.size()) {
+    return false;
+  }
+  auto planDefinition = planDefinitions.begin();
+  for (const auto& [checkName, definition] : definitions) {
+    if (planDefinition->name != checkName || planDefinition->className != definition.className ||
+        planDefinition->libraryName != definition.libraryName) {
+      return false;
+    }
+    ++planDefinition;
+  }
+  return true;
+}
 
-  mLogger << "Running " << checks.size() << " checks for \"" << mo->getName() << "\""
+std::shared_ptr<const Checker::CheckPlan> Checker::resolveChecks(const MonitorObject& mo)
+{
+  auto& plan = mCheckPlans[mo.GetName()];
+  const auto& definitions = mo.getChecks();
+  if (plan && sameDefinitions(plan->definitions, definitions)) {
+    return plan;
+  }
+
+  // First time we see this object or its checks changed. The previous plan is not modified, since it might still be
+  // referred to.
+  auto newPlan = std::make_shared<CheckPlan>();
+  for (const auto& [checkName, definition] : definitions) {
+    loadLibrary(definition.libraryName);
+    newPlan->checks.emplace_back(checkName, getCheck(checkName, definition.className));
+    newPlan->definitions.push_back(definition);
+    newPlan->definitions.back().name = checkName;
+  }
+  mLogger << "Prepared " << newPlan->checks.size() << " checks for \"" << mo.getName() << "\""
           << AliceO2::InfoLogger::InfoLogger::endm;
-  // Get the Checks
+  plan = newPlan;
+  return plan;
+}
+
+std::vector<Quality> Checker::check(std::shared_ptr<MonitorObject> mo, const std::vector<ResolvedCheck>& checks)
+{
+  // Nothing is logged here because it might run in several threads at once, the caller logs the results.
+  std::vector<Quality> qualities;
+  qualities.reserve(checks.size());
 
   // Loop over the Checks and execute them followed by the beautification
-  for (const auto& [checkName, check] : checks) {
-    mLogger << "        check name : " << checkName << AliceO2::InfoLogger::InfoLogger::endm;
-    mLogger << "        check className : " << check.className << AliceO2::InfoLogger::InfoLogger::endm;
-    mLogger << "        check libraryName : " << check.libraryName << AliceO2::InfoLogger::InfoLogger::endm;
-
-    // load module, instantiate, use check
-    // TODO : preload modules and pre-instantiate, or keep a cache
-    loadLibrary(check.libraryName);
-    CheckInterface* checkInstance = getCheck(checkName, check.className);
+  for (const auto& [checkName, checkInstance] : checks) {
     Quality q = checkInstance->check(mo.get());
-
-    mLogger << "  result of the check " << checkName << ": " << q.getName()
-            << AliceO2::InfoLogger::InfoLogger::endm;
-
+    mo->setQualityForCheck(checkName, q);
     checkInstance->beautify(mo.get(), q);
+    qualities.push_back(q);
   }
+  return qualities;
 }
 
-void Checker::store(std::shared_ptr<MonitorObject> mo)
+void Checker::store(std::shared_ptr<MonitorObject> mo, const StorageDeduplicator::Content& content)
 {
+  if (mDatabaseWriter) {
+    std::function<void(bool)> onStored;
+    if (mDeduplicator) {
+      // so that the next version is stored, even if it is identical
+      onStored = [deduplicator = mDeduplicator.get(), name = mo->getName(), content](bool stored) {
+        if (!stored) {
+          deduplicator->storageFailed(name, content);
+        }
+      };
+    }
+    mDatabaseWriter->store(mo, std::move(onStored));
+    return;
+  }
+
   mLogger << "Storing \"" << mo->getName() << "\"" << AliceO2::InfoLogger::InfoLogger::endm;
   try {
     mDatabase->store(mo);
   } catch (boost::exception& e) {
     mLogger << "Unable to " << diagnostic_information(e) << AliceO2::InfoLogger::InfoLogger::endm;
+    if (mDeduplicator) {
+      mDeduplicator->storageFailed(mo->getName(), content);
+    }
   }
 }
 
@@ -178,8 +303,25 @@ void Checker::send(std::unique_ptr<TObjArray>& moArray, framework::DataAllocator
 {
   mLogger << "Sending Monitor Object array with " << moArray->GetEntries() << " objects inside." << AliceO2::InfoLogger::InfoLogger::endm;
 
-  allocator.adopt(
-    framework::Output{ mOutputSpec.origin, mOutputSpec.description, mOutputSpec.subSpec, mOutputSpec.lifetime }, moArray.release());
+  // snapshot serializes the objects right away, thus they don't have to outlive this call
+  allocator.snapshot(
+    framework::Output{ mOutputSpec.origin, mOutputSpec.description, mOutputSpec.subSpec, mOutputSpec.lifetime }, *moArray);
+}
+
+void Checker::sendStorageStatistics()
+{
+  if (mDeduplicator) {
+    mCollector->send({ (int)mDeduplicator->getNumberOfDeduplicated(), "QC_checker_Storage_objects_deduplicated" });
+  }
+  if (!mDatabaseWriter) {
+    return;
+  }
+  auto statistics = mDatabaseWriter->getStatistics();
+  mCollector->send({ (int)statistics.queueSize, "QC_checker_Storage_queue_size" }); // cast due to Monitoring accepting only int
+  mCollector->send({ (int)statistics.stored, "QC_checker_Storage_objects_stored" });
+  mCollector->send({ (int)statistics.failed, "QC_checker_Storage_objects_failed" });
+  mCollector->send({ (int)statistics.coalesced, "QC_checker_Storage_objects_coalesced" });
+  mCollector->send({ (int)statistics.dropped, "QC_checker_Storage_objects_dropped" });
 }
 
 void Checker::loadLibrary(const std::string libraryName)
@@ -191,7 +333,7 @@ void Checker::loadLibrary(const std::string libraryName)
 
   std::string library = "lib" + libraryName;
   // if vector does not contain -> first time we see it
-  if (std::find(mLibrariesLoaded.begin(), mLibrariesLoaded.end(), library) == mLibrariesLoaded.end()) {
+  if (mLibrariesLoaded.count(library) == 0) {
     mLogger << "Loading library " << library << AliceO2::InfoLogger::InfoLogger::endm;
     int libLoaded = gSystem->Load(library.c_str(), "", true);
     if (libLoaded == 1) {
@@ -199,7 +341,7 @@ void Checker::loadLibrary(const std::string libraryName)
     } else if (libLoaded < 0 || libLoaded > 1) {
       BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Failed to load Detector Publisher Library"));
     }
-    mLibrariesLoaded.push_back(library);
+    mLibrariesLoaded.insert(library);
   }
 }
 
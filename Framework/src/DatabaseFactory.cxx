@@ -13,7 +13,9 @@
 // O2
 #include "Common/Exceptions.h"
 // QC
+#include "QualityControl/CachedDatabase.h"
 #include "QualityControl/DatabaseFactory.h"
+#include "QualityControl/LocalDatabase.h"
 #include "QualityControl/QcInfoLogger.h"
 #include "QualityControl/TaskInterface.h"
 #ifdef _WITH_MYSQL
@@ -27,8 +29,13 @@ using namespace o2::quality_control::core;
 namespace o2::quality_control::repository
 {
 
-std::unique_ptr<DatabaseInterface> DatabaseFactory::create(std::string name)
+std::unique_ptr<DatabaseInterface> DatabaseFactory::create(std::string name, bool cache)
 {
+  if (cache) {
+    QcInfoLogger::GetInstance() << "Objects read are cached" << QcInfoLogger::endm;
+    return std::make_unique<CachedDatabase>(create(name));
+  }
+
   if (name == "MySql") {
     QcInfoLogger::GetInstance() << "MySQL backend selected" << QcInfoLogger::endm;
 #ifdef _WITH_MYSQL
@@ -41,6 +48,9 @@ std::unique_ptr<DatabaseInterface> DatabaseFactory::create(std::string name)
     // TODO check if CCDB installed
     QcInfoLogger::GetInstance() << "CCDB backend selected" << QcInfoLogger::endm;
     return std::make_unique<CcdbDatabase>();
+  } else if (name == "Local") {
+    QcInfoLogger::GetInstance() << "Local backend selected" << QcInfoLogger::endm;
+    return std::make_unique<LocalDatabase>();
   } else {
     BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("No database named " + name));
   }
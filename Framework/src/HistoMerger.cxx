@@ -4,8 +4,16 @@
 ///
 
 #include "QualityControl/HistoMerger.h"
+#include "QualityControl/CycleHeader.h"
+#include "QualityControl/MonitorObjectsSerializer.h"
 
+#include <algorithm>
+#include <unordered_map>
+
+#include <FairLogger.h>
 #include <Framework/DataRefUtils.h>
+#include <Headers/Stack.h>
+#include <TList.h>
 #include <TObjArray.h>
 
 using o2::header::DataDescription;
@@ -17,49 +25,158 @@ namespace o2::quality_control::core
 {
 
 HistoMerger::HistoMerger(std::string mergerName, double publicationPeriodSeconds)
-  : mMergerName(mergerName), mOutputSpec{ header::gDataOriginInvalid, header::gDataDescriptionInvalid }
+  : mMergerName(mergerName),
+    mPublicationPeriodUs(static_cast<int>(publicationPeriodSeconds * 1000000)),
+    mOutputSpec{ header::gDataOriginInvalid, header::gDataDescriptionInvalid }
 {
-  mPublicationTimer.reset(static_cast<int>(publicationPeriodSeconds * 1000000));
+  mPublicationTimer.reset(mPublicationPeriodUs);
   mMergedArray.SetOwner(true);
 }
 
 HistoMerger::~HistoMerger() {}
 
-void HistoMerger::init(framework::InitContext&) { mMergedArray.Clear(); }
+void HistoMerger::init(framework::InitContext&)
+{
+  mMergedArray.Clear();
+  mMergedIndex.clear();
+  for (auto& received : mReceivedCycles) {
+    received.second = 0;
+  }
+  mPublishedCycles = 0;
+}
 
 void HistoMerger::run(framework::ProcessingContext& ctx)
 {
+  std::vector<DataRef> inputs;
   for (const auto& input : ctx.inputs()) {
     if (input.header != nullptr && input.spec != nullptr) {
-      std::unique_ptr<TObjArray> moArray = DataRefUtils::as<TObjArray>(input);
-
-      if (mMergedArray.IsEmpty()) {
-        mMergedArray = *moArray.release();
-      } else {
-        if (mMergedArray.GetSize() != moArray->GetSize()) {
-          LOG(ERROR) << "array don't match in size, " << mMergedArray.GetSize() << " vs " << moArray->GetSize();
-          return;
-        }
-
-        for (int i = 0; i < mMergedArray.GetEntries(); i++) {
-          MonitorObject* mo = dynamic_cast<MonitorObject*>((*moArray)[i]);
-          if (mo && std::strstr(mo->getObject()->ClassName(), "TH1") != nullptr) {
-            TH1* h = dynamic_cast<TH1*>(dynamic_cast<MonitorObject*>(mMergedArray[i])->getObject());
-            const TH1* hUpdate = dynamic_cast<TH1*>(mo->getObject());
-            h->Add(hUpdate);
-          }
-        }
-      }
+      inputs.push_back(input);
     }
   }
-  if (mPublicationTimer.isTimeout()) {
-    if (!mMergedArray.IsEmpty()) {
-      ctx.outputs().snapshot(Output{ mOutputSpec.origin, mOutputSpec.description, mOutputSpec.subSpec }, mMergedArray);
+  merge(inputs);
+
+  if (preparePublication()) {
+    publish(ctx);
+  }
+}
+
+bool HistoMerger::preparePublication()
+{
+  auto fewerCycles = [](const auto& a, const auto& b) { return a.second < b.second; };
+  if (mPublicationOnCompletion && isCycleComplete()) {
+    mPublishedCycles = std::min_element(mReceivedCycles.begin(), mReceivedCycles.end(), fewerCycles)->second;
+    mPublicationTimer.reset(mPublicationPeriodUs);
+    return true;
+  } else if (mPublicationTimer.isTimeout()) {
+    if (mPublicationOnCompletion && !isCycleComplete()) {
+      LOG(WARNING) << mMergerName << " did not receive all the inputs of the cycle " << mPublishedCycles
+                   << " on time, publishing what was merged so far";
+    }
+    // the late inputs are merged in the next publication
+    if (!mReceivedCycles.empty()) {
+      mPublishedCycles = std::max_element(mReceivedCycles.begin(), mReceivedCycles.end(), fewerCycles)->second;
     }
     // avoid publishing mo many times consecutively because of too long initial waiting time
     do {
       mPublicationTimer.increment();
     } while (mPublicationTimer.isTimeout());
+    return true;
+  }
+  return false;
+}
+
+void HistoMerger::merge(const std::vector<DataRef>& inputs)
+{
+  // The updates of each object are gathered across the inputs, so that they are merged in one go.
+  std::unordered_map<std::string, std::vector<std::unique_ptr<MonitorObject>>> updates;
+
+  for (const auto& input : inputs) {
+    const auto* dataHeader = header::get<header::DataHeader*>(input.header);
+    if (auto received = mReceivedCycles.find(dataHeader->subSpecification); received != mReceivedCycles.end()) {
+      updateCycle(received->second, header::get<CycleHeader*>(input.header));
+    }
+
+    MonitorObjectsView objects(input);
+
+    // Objects are matched by name, because the inputs might contain only a subset of the objects, in any order
+    // (e.g. tasks in delta publication mode send only the modified ones, tasks can publish new objects at any time).
+    for (size_t i = 0; i < objects.size(); i++) {
+      std::unique_ptr<MonitorObject> mo = objects.get(i);
+      if (mo == nullptr) {
+        continue;
+      }
+
+      auto merged = mMergedIndex.find(mo->getName());
+      if (merged == mMergedIndex.end()) {
+        // first version of this object, it becomes the merged one
+        mMergedIndex.emplace(mo->getName(), mo.get());
+        mMergedArray.Add(mo.release());
+        continue;
+      }
+      updates[merged->first].push_back(std::move(mo));
+    }
+  }
+
+  for (const auto& [name, mos] : updates) {
+    MonitorObject* mergedMo = mMergedIndex.at(name);
+    TList objects;
+    for (const auto& mo : mos) {
+      if (mo->getObject() != nullptr) {
+        objects.Add(mo->getObject());
+      }
+    }
+    if (!mObjectMerger.merge(name, mergedMo->getObject(), objects) && mNotMergeable.insert(name).second) {
+      LOG(WARNING) << mMergerName << " cannot merge the object " << name << " of class "
+                   << (mergedMo->getObject() ? mergedMo->getObject()->ClassName() : "null")
+                   << ", only its first version is published";
+    }
+  }
+}
+
+void HistoMerger::updateCycle(size_t& received, const CycleHeader* cycleHeader)
+{
+  if (cycleHeader == nullptr) {
+    // the producer does not tell its cycle, it is assumed to publish once per cycle without loss
+    received++;
+    return;
+  }
+  size_t next = cycleHeader->cycle + 1;
+  if (next < received) {
+    // the input restarted its cycles (e.g. its process was restarted), the others are likely to do the same
+    LOG(INFO) << mMergerName << " received the cycle " << cycleHeader->cycle << " after the cycle " << received - 1
+              << ", it restarts waiting for all the inputs";
+    for (auto& other : mReceivedCycles) {
+      other.second = 0;
+    }
+    mPublishedCycles = 0;
+  }
+  received = next;
+}
+
+bool HistoMerger::isCycleComplete() const
+{
+  return !mReceivedCycles.empty() &&
+         std::all_of(mReceivedCycles.begin(), mReceivedCycles.end(),
+                     [this](const auto& received) { return received.second > mPublishedCycles; });
+}
+
+void HistoMerger::publish(framework::ProcessingContext& ctx)
+{
+  if (mMergedArray.IsEmpty()) {
+    return;
+  }
+  // the upper mergers of a tree need the cycle as well
+  uint64_t cycle = mPublishedCycles > 0 ? mPublishedCycles - 1 : 0;
+  ctx.outputs().snapshot(Output{ mOutputSpec.origin, mOutputSpec.description, mOutputSpec.subSpec,
+                                 Lifetime::Timeframe, header::Stack{ CycleHeader{ cycle } } },
+                         mMergedArray);
+  if (!mObjectMerger.getStatistics().empty()) {
+    LOG(INFO) << mMergerName << " merge times - " << mObjectMerger.getStatisticsSummary();
+    mObjectMerger.resetStatistics();
+  }
+  if (mResetAfterPublication) {
+    mMergedArray.Clear(); // it is the owner, the objects are deleted
+    mMergedIndex.clear();
   }
 }
 
@@ -68,10 +185,28 @@ void HistoMerger::configureInputsOutputs(DataOrigin origin, DataDescription desc
 {
   mInputSpecs.clear();
 
+  mReceivedCycles.clear();
+
   for (SubSpecificationType s = subSpecRange.first; s <= subSpecRange.second; s++) {
     mInputSpecs.push_back({ "mo", origin, description, s });
+    mReceivedCycles[s] = 0;
   }
   mOutputSpec = OutputSpec{ origin, description, 0 };
 }
 
-} // namespace o2::quality_control::core
\ No newline at end of file
+void HistoMerger::configureInputsOutputs(DataOrigin origin, DataDescription description,
+                                         const std::vector<SubSpecificationType>& inputSubSpecs,
+                                         SubSpecificationType outputSubSpec)
+{
+  mInputSpecs.clear();
+
+  mReceivedCycles.clear();
+
+  for (auto s : inputSubSpecs) {
+    mInputSpecs.push_back({ "mo", origin, description, s });
+    mReceivedCycles[s] = 0;
+  }
+  mOutputSpec = OutputSpec{ origin, description, outputSubSpec };
+}
+
+} // namespace o2::quality_control::core
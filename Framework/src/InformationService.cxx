@@ -16,8 +16,15 @@
 
 #include "InformationService.h"
 #include "QualityControl/QcInfoLogger.h"
+#include <boost/functional/hash.hpp>
 #include <boost/token_functions.hpp>
 #include <boost/tokenizer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
 
 using namespace std;
 typedef boost::tokenizer<boost::char_separator<char>> t_tokenizer;
@@ -25,7 +32,13 @@ using namespace o2::quality_control::core;
 
 int timeOutIntervals = 5; // in seconds
 
-InformationService::InformationService() : th(nullptr), mFakeDataIndex(0)
+InformationService::InformationService()
+  : mDeltaUpdates(false),
+    mEpoch(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+             .count()),
+    mSequence(0),
+    th(nullptr),
+    mFakeDataIndex(0)
 {
   OnData("tasks_input", &InformationService::handleTaskInputData);
   OnData("request_data", &InformationService::handleRequestData);
@@ -34,6 +47,11 @@ InformationService::InformationService() : th(nullptr), mFakeDataIndex(0)
 void InformationService::Init()
 {
   string fakeDataFile = fConfig->GetValue<string>("fake-data-file");
+  string updatesFormat = fConfig->GetValue<string>("updates-format");
+  if (updatesFormat != "full" && updatesFormat != "delta") {
+    LOG(ERROR) << "Unknown updates format \"" << updatesFormat << "\", the full lists of objects are published";
+  }
+  mDeltaUpdates = updatesFormat == "delta";
 
   // todo put this in a method
   if (fakeDataFile != "") {
@@ -63,10 +81,9 @@ bool InformationService::handleRequestData(FairMQMessagePtr& request, int /*inde
   if (requestParam == "all") {
     result = new string(produceJsonAll());
   } else {
-    if (mCacheTasksData.count(requestParam) > 0) {
-      result = new string(produceJson(requestParam));
-    } else {
-      result = new string("{\"error\": \"no such task\"}");
+    result = new string(produceJson(requestParam));
+    if (result->empty()) {
+      *result = "{\"error\": \"no such task\"}";
     }
   }
 
@@ -101,25 +118,35 @@ bool InformationService::handleTaskInputData(std::string receivedData)
   // check if new data
   boost::hash<std::string> string_hash;
   size_t hash = string_hash(receivedData);
-  if (mCacheTasksObjectsHash.count(taskName) > 0) {
-    if (mCacheTasksObjectsHash.count(taskName) > 0 && hash == mCacheTasksObjectsHash[taskName]) {
-      LOG(INFO) << "Data already known, we skip it";
-      return true;
-    }
+  std::unique_lock<std::mutex> lock(mCacheMutex);
+  if (mCacheTasksObjectsHash.count(taskName) > 0 && hash == mCacheTasksObjectsHash[taskName]) {
+    LOG(INFO) << "Data already known, we skip it";
+    return true;
   }
   mCacheTasksObjectsHash[taskName] = hash;
 
   // parse
   vector<string> objects = getObjects(&receivedData);
 
-  // store
-  mCacheTasksData[taskName] = objects;
+  // json, only this task's one is serialized again
+  mSequence++;
+  mCacheTasksJson[taskName] = buildTaskJson(taskName, objects);
+  mCacheJsonAll.clear();
+  string* json = nullptr;
+  if (mDeltaUpdates) {
+    vector<string> added, removed;
+    diffObjects(mCacheTasksData[taskName], objects, added, removed);
+    json = new std::string(buildTaskDeltaJson(mEpoch, mSequence, taskName, added, removed));
+  } else {
+    json = new std::string(mCacheTasksJson[taskName]);
+  }
 
-  // json
-  string* json = new std::string(produceJson(taskName));
+  // store
+  mCacheTasksData[taskName] = std::move(objects);
 
-  // publish
+  // publish, under the lock so that the updates are sent in the order of their sequence numbers
   sendJson(json);
+  return true;
 }
 
 void InformationService::readFakeDataFile(std::string fakeDataFile)
@@ -160,49 +187,113 @@ std::string InformationService::getTaskName(std::string* receivedData)
   return receivedData->substr(0, receivedData->find(":"));
 }
 
-pt::ptree InformationService::buildTaskNode(std::string taskName)
+namespace
+{
+void appendJsonString(std::string& json, const std::string& value)
 {
-  pt::ptree task_node;
-  task_node.put("name", taskName);
-  pt::ptree objects_node;
-  for (auto& object : mCacheTasksData[taskName]) {
-    pt::ptree object_node;
-    object_node.put("id", object);
-    objects_node.push_back(std::make_pair("", object_node));
+  json += '"';
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        json += "\\\"";
+        break;
+      case '\\':
+        json += "\\\\";
+        break;
+      case '\n':
+        json += "\\n";
+        break;
+      case '\t':
+        json += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          json += escaped;
+        } else {
+          json += c;
+        }
+    }
   }
-  task_node.add_child("objects", objects_node);
-  return task_node;
+  json += '"';
 }
 
-std::string InformationService::produceJson(std::string taskName)
+void appendJsonObjects(std::string& json, const std::vector<std::string>& objects)
 {
-  pt::ptree taskNode = buildTaskNode(taskName);
+  json += '[';
+  for (size_t i = 0; i < objects.size(); i++) {
+    json += i == 0 ? "{\"id\":" : ",{\"id\":";
+    appendJsonString(json, objects[i]);
+    json += '}';
+  }
+  json += ']';
+}
+} // namespace
 
-  std::stringstream ss;
-  pt::json_parser::write_json(ss, taskNode);
-  LOG(DEBUG) << "json : " << endl
-             << ss.str();
-  //  QcInfoLogger::GetInstance() << infologger::Debug << "json : \n" << *json << infologger::endm;
-  return ss.str();
+std::string InformationService::buildTaskJson(const std::string& taskName, const std::vector<std::string>& objects)
+{
+  string json = "{\"name\":";
+  appendJsonString(json, taskName);
+  json += ",\"objects\":";
+  appendJsonObjects(json, objects);
+  json += '}';
+  return json;
 }
 
-std::string InformationService::produceJsonAll()
+std::string InformationService::buildTaskDeltaJson(uint64_t epoch, uint64_t sequence, const std::string& taskName,
+                                                   const std::vector<std::string>& added,
+                                                   const std::vector<std::string>& removed)
 {
-  string result;
-  pt::ptree main_node;
+  string json = "{\"epoch\":" + to_string(epoch) + ",\"sequence\":" + to_string(sequence) + ",\"name\":";
+  appendJsonString(json, taskName);
+  json += ",\"added\":";
+  appendJsonObjects(json, added);
+  json += ",\"removed\":";
+  appendJsonObjects(json, removed);
+  json += '}';
+  return json;
+}
 
-  pt::ptree tasksListNode;
-  for (const auto& taskTuple : mCacheTasksData) {
-    pt::ptree taskNode = buildTaskNode(taskTuple.first);
-    tasksListNode.push_back(std::make_pair("", taskNode));
-  }
-  main_node.add_child("tasks", tasksListNode);
+void InformationService::diffObjects(const std::vector<std::string>& previous, const std::vector<std::string>& current,
+                                     std::vector<std::string>& added, std::vector<std::string>& removed)
+{
+  unordered_set<string> previousSet(previous.begin(), previous.end());
+  unordered_set<string> currentSet(current.begin(), current.end());
+  copy_if(current.begin(), current.end(), back_inserter(added), [&](const string& o) { return !previousSet.count(o); });
+  copy_if(previous.begin(), previous.end(), back_inserter(removed),
+          [&](const string& o) { return !currentSet.count(o); });
+}
+
+std::string InformationService::produceJson(std::string taskName)
+{
+  std::lock_guard<std::mutex> lock(mCacheMutex);
+  auto json = mCacheTasksJson.find(taskName);
+  return json != mCacheTasksJson.end() ? json->second : string();
+}
 
-  std::stringstream ss;
-  pt::json_parser::write_json(ss, main_node);
-  LOG(DEBUG) << "json : " << endl
-             << ss.str();
-  return ss.str();
+std::string InformationService::produceJsonAll()
+{
+  std::lock_guard<std::mutex> lock(mCacheMutex);
+  if (mCacheJsonAll.empty()) {
+    size_t size = 0;
+    for (const auto& task : mCacheTasksJson) {
+      size += task.second.size() + 1;
+    }
+    string json;
+    json.reserve(size + 64);
+    json = "{\"epoch\":" + to_string(mEpoch) + ",\"sequence\":" + to_string(mSequence) + ",\"tasks\":[";
+    for (const auto& task : mCacheTasksJson) {
+      json += task.second;
+      json += ',';
+    }
+    if (json.back() == ',') {
+      json.pop_back();
+    }
+    json += "]}";
+    mCacheJsonAll = std::move(json);
+  }
+  return mCacheJsonAll;
 }
 
 void InformationService::sendJson(std::string* json)
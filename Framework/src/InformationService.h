@@ -21,10 +21,7 @@
 #include <InfoLogger/InfoLogger.hxx>
 
 #include <boost/asio.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
-
-namespace pt = boost::property_tree;
+#include <mutex>
 
 /// \brief Collect the list of objects published by all the tasks and make it available to clients.
 ///
@@ -46,6 +43,15 @@ namespace pt = boost::property_tree;
 /// Format of the JSON output for one task or all tasks :
 ///      See README
 ///
+/// The JSON of each task is serialized once, when its list of objects changes, and the JSON for all tasks is the
+/// concatenation of the ones of the tasks. It is kept as well until a task changes.
+///
+/// With the option `--updates-format delta`, the updates contain only the objects added and removed, along with a
+/// sequence number incremented at every update. The JSON for all tasks carries the sequence number of the last update
+/// it includes, so that new subscribers can take it as a snapshot and apply the following updates.
+/// The sequence numbers restart at 0 when the service restarts, the replies and the updates thus carry as well an
+/// epoch, the time at which the service started, to tell them apart.
+///
 /// \todo Handle tasks dying and their removal from the cache and the publication of an update (heartbeat ?).
 /// \todo Handle tasks sending information that they are disappearing.
 
@@ -55,6 +61,15 @@ class InformationService : public FairMQDevice
   InformationService();
   virtual ~InformationService();
 
+  /// Serialize the JSON of a task from its list of objects
+  static std::string buildTaskJson(const std::string& taskName, const std::vector<std::string>& objects);
+  /// Serialize the JSON of the changes of the objects of a task, with the epoch and the sequence number of the update
+  static std::string buildTaskDeltaJson(uint64_t epoch, uint64_t sequence, const std::string& taskName,
+                                        const std::vector<std::string>& added, const std::vector<std::string>& removed);
+  /// Compute the objects added and removed from the previous list of objects of a task, in the order of the lists
+  static void diffObjects(const std::vector<std::string>& previous, const std::vector<std::string>& current,
+                          std::vector<std::string>& added, std::vector<std::string>& removed);
+
  protected:
   /// Callback for data coming from qcTasks
   bool handleTaskInputData(FairMQMessagePtr&, int);
@@ -73,7 +88,6 @@ class InformationService : public FairMQDevice
   std::string produceJsonAll();
   /// Send the JSON string to all clients (subscribers)
   void sendJson(std::string* json);
-  pt::ptree buildTaskNode(std::string taskName);
   void checkTimedOut();
   /// Compute and send the JSON using the inputString from a task
   bool handleTaskInputData(std::string inputString);
@@ -85,7 +99,13 @@ class InformationService : public FairMQDevice
  private:
   std::map<std::string, std::vector<std::string>> mCacheTasksData; /// the list of objects names for each task
   std::map<std::string /*task name*/, size_t /*hash of the objects list*/>
-    mCacheTasksObjectsHash;            /// used to check whether we already have received this list of objects
+    mCacheTasksObjectsHash; /// used to check whether we already have received this list of objects
+  std::map<std::string, std::string> mCacheTasksJson; /// the JSON of each task
+  std::string mCacheJsonAll;                          /// the JSON of all tasks, empty when it must be rebuilt
+  std::mutex mCacheMutex;                             /// the fake data are handled by the timer's thread
+  bool mDeltaUpdates;                                 /// whether only the changes are published
+  uint64_t mEpoch;                                    /// start time of the service in ms, to detect its restarts
+  uint64_t mSequence;                                 /// number of updates so far
   boost::asio::deadline_timer* mTimer; /// the asynchronous timer to check if agents have timed out
   std::vector<std::string>
     mFakeData; /// container for the fake data (if any). Each line is in a string and used in turn.
@@ -10,6 +10,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <QualityControl/HistoMerger.h>
 #include <QualityControl/TaskRunner.h>
+#include <QualityControl/QcInfoLogger.h>
 
 using namespace o2::framework;
 using namespace o2::configuration;
@@ -19,6 +20,24 @@ using boost::property_tree::ptree;
 namespace o2::quality_control::core
 {
 
+/// Reads "mergerFanIn" of a task, either one value for all the layers of mergers or a list with a value per layer.
+static std::vector<size_t> getMergerFanIns(const ptree& taskConfig)
+{
+  std::vector<size_t> fanIns;
+  auto fanInConfig = taskConfig.get_child_optional("mergerFanIn");
+  if (!fanInConfig) {
+    return fanIns;
+  }
+  if (fanInConfig->empty()) {
+    fanIns.push_back(fanInConfig->get_value<size_t>());
+  } else {
+    for (const auto& fanIn : *fanInConfig) {
+      fanIns.push_back(fanIn.second.get_value<size_t>());
+    }
+  }
+  return fanIns;
+}
+
 WorkflowSpec InfrastructureGenerator::generateLocalInfrastructure(std::string configurationSource, std::string host)
 {
   WorkflowSpec workflow;
@@ -67,20 +86,14 @@ o2::framework::WorkflowSpec InfrastructureGenerator::generateRemoteInfrastructur
 
         //todo use real mergers when they are done
 
-        // generate merger only, when there is a need to merge something
+        // generate mergers only, when there is a need to merge something
         if (taskConfig.get_child("machines").size() > 1) {
-          HistoMerger merger(taskName + "-merger", 1);
-          merger.configureInputsOutputs(TaskRunner::createTaskDataOrigin(),
-                                        TaskRunner::createTaskDataDescription(taskName),
-                                        { 1, taskConfig.get_child("machines").size() });
-          DataProcessorSpec mergerSpec{
-            merger.getName(),
-            merger.getInputSpecs(),
-            Outputs{ merger.getOutputSpec() },
-            adaptFromTask<HistoMerger>(std::move(merger)),
-          };
-
-          workflow.emplace_back(mergerSpec);
+          std::vector<std::string> machines;
+          for (const auto& machine : taskConfig.get_child("machines")) {
+            machines.push_back(machine.second.get<std::string>(""));
+          }
+          bool publicationOnCompletion = taskConfig.get<std::string>("mergerPublication", "timer") == "completion";
+          generateMergers(workflow, taskName, machines, getMergerFanIns(taskConfig), publicationOnCompletion);
         }
 
       } else if (taskConfig.get<std::string>("location") == "remote") {
@@ -101,4 +114,78 @@ void InfrastructureGenerator::generateRemoteInfrastructure(framework::WorkflowSp
   workflow.insert(std::end(workflow), std::begin(qcInfrastructure), std::end(qcInfrastructure));
 }
 
+void InfrastructureGenerator::generateMergers(WorkflowSpec& workflow, const std::string& taskName,
+                                              const std::vector<std::string>& machines,
+                                              const std::vector<size_t>& fanIns, bool publicationOnCompletion)
+{
+  using SubSpecificationType = header::DataHeader::SubSpecificationType;
+
+  // local tasks publish with SubSpecs 1..N, see generateLocalInfrastructure()
+  std::vector<SubSpecificationType> inputs;
+  for (size_t i = 1; i <= machines.size(); i++) {
+    inputs.push_back(i);
+  }
+  SubSpecificationType nextSubSpec = machines.size() + 1;
+
+  auto addMerger = [&workflow, &taskName, publicationOnCompletion](
+                     const std::string& name, const std::vector<SubSpecificationType>& inputSubSpecs,
+                     SubSpecificationType outputSubSpec, bool intermediate, Options options) {
+    HistoMerger merger(name, 1);
+    merger.configureInputsOutputs(TaskRunner::createTaskDataOrigin(), TaskRunner::createTaskDataDescription(taskName),
+                                  inputSubSpecs, outputSubSpec);
+    // the upper layers accumulate, thus the intermediate mergers send only what they received in the meantime
+    merger.setResetAfterPublication(intermediate);
+    merger.setPublicationOnCompletion(publicationOnCompletion);
+    DataProcessorSpec mergerSpec{
+      merger.getName(),
+      merger.getInputSpecs(),
+      Outputs{ merger.getOutputSpec() },
+      adaptFromTask<HistoMerger>(std::move(merger)),
+      std::move(options),
+    };
+    workflow.emplace_back(mergerSpec);
+  };
+
+  for (size_t layer = 1;; layer++) {
+    size_t fanIn = fanIns.empty() ? 0 : fanIns[std::min(layer, fanIns.size()) - 1];
+    if (fanIn < 2 || inputs.size() <= fanIn) {
+      break;
+    }
+
+    // the inputs are spread evenly, so that the mergers of a layer have the same load
+    size_t numberOfGroups = (inputs.size() + fanIn - 1) / fanIn;
+    std::vector<SubSpecificationType> outputs;
+    size_t numberOfMergers = 0;
+    for (size_t group = 0, first = 0; group < numberOfGroups; group++) {
+      size_t last = first + inputs.size() / numberOfGroups + (group < inputs.size() % numberOfGroups ? 1 : 0);
+      if (last - first == 1) {
+        // a merger would only forward it, the input goes directly to the next layer
+        outputs.push_back(inputs[first]);
+        first = last;
+        continue;
+      }
+      std::string name = taskName + "-merger-" + std::to_string(layer) + "-" + std::to_string(numberOfMergers++);
+      Options options;
+      if (layer == 1) {
+        // placement hint : the first layer is best placed close to the machines it merges. The list is an option of
+        // the device, thus it is part of the dumped workflow and of the generated topology.
+        std::string mergedMachines;
+        for (size_t i = first; i < last; i++) {
+          mergedMachines += (i == first ? "" : ",") + machines[i];
+        }
+        options.push_back(ConfigParamSpec{ "machines", VariantType::String, mergedMachines,
+                                           { "Machines of which the objects are merged, for the placement" } });
+        QcInfoLogger::GetInstance() << name << " merges the objects from " << mergedMachines
+                                    << AliceO2::InfoLogger::InfoLogger::endm;
+      }
+      addMerger(name, { inputs.begin() + first, inputs.begin() + last }, nextSubSpec, true, std::move(options));
+      outputs.push_back(nextSubSpec++);
+      first = last;
+    }
+    inputs = std::move(outputs);
+  }
+
+  addMerger(taskName + "-merger", inputs, 0, false, {});
+}
+
 } // namespace o2::quality_control::core
\ No newline at end of file
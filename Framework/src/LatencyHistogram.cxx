@@ -0,0 +1,102 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   LatencyHistogram.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace o2::quality_control::core
+{
+
+namespace
+{
+constexpr unsigned subBucketBits = 6;
+constexpr uint64_t subBucketCount = uint64_t(1) << subBucketBits; // buckets per power of two
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : mCounts(getIndex(std::numeric_limits<uint64_t>::max()) + 1)
+{
+  reset();
+}
+
+size_t LatencyHistogram::getIndex(uint64_t value)
+{
+  if (value < 2 * subBucketCount) {
+    return value;
+  }
+  // the value is in [2^(shift + 6), 2^(shift + 7)), it is counted with a precision of 2^shift
+  unsigned shift = 63 - __builtin_clzll(value) - subBucketBits;
+  return shift * subBucketCount + (value >> shift);
+}
+
+uint64_t LatencyHistogram::getHighestEquivalentValue(size_t index)
+{
+  if (index < 2 * subBucketCount) {
+    return index;
+  }
+  unsigned shift = index / subBucketCount - 1;
+  uint64_t lowest = (index - shift * subBucketCount) << shift;
+  return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+  mCounts[getIndex(value)]++;
+  mCount++;
+  mMin = std::min(mMin, value);
+  mMax = std::max(mMax, value);
+  mSum += value;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+  for (size_t i = 0; i < mCounts.size(); i++) {
+    mCounts[i] += other.mCounts[i];
+  }
+  mCount += other.mCount;
+  mMin = std::min(mMin, other.mMin);
+  mMax = std::max(mMax, other.mMax);
+  mSum += other.mSum;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(mCounts.begin(), mCounts.end(), 0);
+  mCount = 0;
+  mMin = std::numeric_limits<uint64_t>::max();
+  mMax = 0;
+  mSum = 0;
+}
+
+uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const
+{
+  if (mCount == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * mCount));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t cumulated = 0;
+  for (size_t i = 0; i < mCounts.size(); i++) {
+    cumulated += mCounts[i];
+    if (cumulated >= rank) {
+      return std::min(getHighestEquivalentValue(i), mMax);
+    }
+  }
+  return mMax;
+}
+
+} // namespace o2::quality_control::core
@@ -0,0 +1,576 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   LocalDatabase.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/LocalDatabase.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+// ROOT
+#include <TBufferJSON.h>
+// O2
+#include "Common/Exceptions.h"
+// QC
+#include "QualityControl/MonitorObject.h"
+#include "QualityControl/QcInfoLogger.h"
+
+using namespace AliceO2::Common;
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+// Layout of a record of the index : the fixed size part below, followed by the task name and the object name. A
+// record with the tombstone segment marks the truncation of all the previous versions of the object.
+namespace
+{
+struct IndexRecord {
+  uint64_t timestamp;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t segment;
+  uint16_t taskNameLength;
+  uint16_t objectNameLength;
+};
+static_assert(sizeof(IndexRecord) == 32, "The index records are read and written as they are in memory");
+
+const uint32_t tombstone = std::numeric_limits<uint32_t>::max();
+const uint32_t noSegment = std::numeric_limits<uint32_t>::max();
+const char* indexFileName = "/index.dat";
+const char* compactedIndexFileName = "/index.compact";
+const char* lockFileName = "/lock";
+
+uint64_t now()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+void throwSystemError(const std::string& what)
+{
+  BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details(what + " : " + std::strerror(errno)));
+}
+} // namespace
+
+LocalDatabase::LocalDatabase()
+  : mSegmentSize(defaultSegmentSize), mCurrentSegment(noSegment), mNextSegment(0), mIndexFd(-1), mLockFd(-1),
+    mBuffer(TBuffer::kWrite)
+{
+}
+
+LocalDatabase::~LocalDatabase() { disconnect(); }
+
+void LocalDatabase::connect(std::string host, std::string, std::string, std::string) { open(host); }
+
+void LocalDatabase::connect(const std::unordered_map<std::string, std::string>& config)
+{
+  if (config.count("segmentSize")) {
+    mSegmentSize = std::max<size_t>(std::stoul(config.at("segmentSize")), 1);
+  }
+  open(config.count("path") ? config.at("path") : config.at("host"));
+}
+
+void LocalDatabase::open(const std::string& directory)
+{
+  disconnect();
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throwSystemError("Failed to create the directory " + directory);
+  }
+  // Another connection, in this process or another one, would overwrite the files being written by this one.
+  mLockFd = ::open((directory + lockFileName).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (mLockFd < 0) {
+    throwSystemError("Failed to open the lock of " + directory);
+  }
+  if (::flock(mLockFd, LOCK_EX | LOCK_NB) != 0) {
+    int error = errno;
+    ::close(mLockFd);
+    mLockFd = -1;
+    errno = error;
+    if (error == EWOULDBLOCK) {
+      BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("The local database " + directory +
+                                                                   " is already opened by another connection"));
+    }
+    throwSystemError("Failed to lock " + directory);
+  }
+  mDirectory = directory;
+  ::unlink((mDirectory + compactedIndexFileName).c_str()); // an interrupted compaction
+  loadIndex(mDirectory + indexFileName);
+
+  // The segments which are not referenced by the index are left over by an interrupted compaction, or empty.
+  std::set<uint32_t> referenced;
+  for (const auto& [taskName, objects] : mIndex) {
+    for (const auto& [objectName, versions] : objects) {
+      for (const auto& version : versions) {
+        referenced.insert(version.segment);
+      }
+    }
+  }
+  DIR* dir = ::opendir(mDirectory.c_str());
+  if (dir == nullptr) {
+    throwSystemError("Failed to list the directory " + mDirectory);
+  }
+  while (dirent* entry = ::readdir(dir)) {
+    unsigned int number;
+    char extra;
+    if (std::sscanf(entry->d_name, "segment-%u.dat%c", &number, &extra) != 1) {
+      continue;
+    }
+    mNextSegment = std::max<uint32_t>(mNextSegment, number + 1);
+    std::string path = getSegmentPath(number);
+    if (referenced.count(number) == 0) {
+      ::unlink(path.c_str());
+      continue;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      ::closedir(dir);
+      throwSystemError("Failed to open " + path);
+    }
+    Segment segment;
+    segment.used = segment.mapped = status.st_size;
+    if (segment.mapped > 0) {
+      void* data = ::mmap(nullptr, segment.mapped, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED) {
+        ::close(fd);
+        ::closedir(dir);
+        throwSystemError("Failed to map " + path);
+      }
+      segment.data = static_cast<char*>(data);
+    }
+    ::close(fd); // the mapping remains
+    mSegments[number] = segment;
+  }
+  ::closedir(dir);
+
+  // versions whose data did not make it to the disk
+  for (auto task = mIndex.begin(); task != mIndex.end();) {
+    for (auto object = task->second.begin(); object != task->second.end();) {
+      auto& versions = object->second;
+      versions.erase(std::remove_if(versions.begin(), versions.end(),
+                                    [this](const Version& version) {
+                                      auto segment = mSegments.find(version.segment);
+                                      return segment == mSegments.end() ||
+                                             version.offset + version.size > segment->second.used;
+                                    }),
+                     versions.end());
+      object = versions.empty() ? task->second.erase(object) : std::next(object);
+    }
+    task = task->second.empty() ? mIndex.erase(task) : std::next(task);
+  }
+
+  mIndexFd = ::open((mDirectory + indexFileName).c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (mIndexFd < 0) {
+    throwSystemError("Failed to open the index of " + mDirectory);
+  }
+  QcInfoLogger::GetInstance() << "Local database opened in " << mDirectory << " (" << mIndex.size() << " tasks, "
+                              << mSegments.size() << " segments)" << infologger::endm;
+}
+
+void LocalDatabase::loadIndex(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  size_t position = 0;
+  while (position + sizeof(IndexRecord) <= content.size()) {
+    IndexRecord record;
+    std::memcpy(&record, content.data() + position, sizeof(record));
+    size_t namesStart = position + sizeof(record);
+    size_t recordEnd = namesStart + record.taskNameLength + record.objectNameLength;
+    if (recordEnd > content.size()) {
+      break;
+    }
+    std::string taskName = content.substr(namesStart, record.taskNameLength);
+    std::string objectName = content.substr(namesStart + record.taskNameLength, record.objectNameLength);
+    position = recordEnd;
+
+    if (record.segment == tombstone) {
+      if (auto task = mIndex.find(taskName); task != mIndex.end()) {
+        task->second.erase(objectName);
+        if (task->second.empty()) {
+          mIndex.erase(task);
+        }
+      }
+    } else {
+      mIndex[taskName][objectName].push_back(Version{ record.timestamp, record.segment, record.offset, record.size });
+    }
+  }
+  if (position < content.size()) { // the last record was not completely written
+    QcInfoLogger::GetInstance() << "The index of the local database ends with an incomplete record, it is dropped"
+                                << infologger::endm;
+    if (::truncate(path.c_str(), position) != 0) {
+      throwSystemError("Failed to repair " + path);
+    }
+  }
+}
+
+void LocalDatabase::store(std::shared_ptr<MonitorObject> mo)
+{
+  if (mo->getName().length() == 0 || mo->getTaskName().length() == 0) {
+    BOOST_THROW_EXCEPTION(DatabaseException()
+                          << errinfo_details("Object and task names can't be empty. Do not store."));
+  }
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mIndexFd < 0) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the local database. Do not store."));
+  }
+
+  mBuffer.Reset();
+  mBuffer.WriteObject(mo.get());
+  // the data is written before its index record, so that the index never refers to missing data
+  Version version = append(mBuffer.Buffer(), mBuffer.Length(), now());
+  writeIndexRecord(mIndexFd, mo->getTaskName(), mo->getName(), version);
+  mIndex[mo->getTaskName()][mo->getName()].push_back(version);
+}
+
+MonitorObject* LocalDatabase::retrieve(std::string taskName, std::string objectName)
+{
+  std::lock_guard<std::mutex> lock(mMutex); // the segments are not compacted meanwhile
+  const auto* versions = findVersions(taskName, objectName);
+  return versions != nullptr ? deserialize(view(versions->back())).release() : nullptr;
+}
+
+std::string LocalDatabase::retrieveJson(std::string taskName, std::string objectName)
+{
+  std::unique_ptr<MonitorObject> monitor(retrieve(taskName, objectName));
+  if (monitor == nullptr) {
+    return std::string();
+  }
+  TString json = TBufferJSON::ConvertToJSON(monitor->getObject());
+  return json.Data();
+}
+
+void LocalDatabase::disconnect()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  closeSegment();
+  for (auto& [number, segment] : mSegments) {
+    if (segment.data != nullptr) {
+      ::munmap(segment.data, segment.mapped);
+    }
+  }
+  mSegments.clear();
+  if (mIndexFd >= 0) {
+    ::close(mIndexFd);
+    mIndexFd = -1;
+  }
+  mIndex.clear();
+  mNextSegment = 0;
+  if (mLockFd >= 0) {
+    ::close(mLockFd); // releases the lock, the file is kept as removing it would race with the next connection
+    mLockFd = -1;
+  }
+}
+
+void LocalDatabase::prepareTaskDataContainer(std::string)
+{
+  // NOOP for the local database
+}
+
+std::vector<std::string> LocalDatabase::getListOfTasksWithPublications()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<std::string> tasks;
+  for (const auto& [taskName, objects] : mIndex) {
+    tasks.push_back(taskName);
+  }
+  return tasks;
+}
+
+std::vector<std::string> LocalDatabase::getPublishedObjectNames(std::string taskName)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<std::string> names;
+  if (auto task = mIndex.find(taskName); task != mIndex.end()) {
+    for (const auto& [objectName, versions] : task->second) {
+      names.push_back(objectName);
+    }
+  }
+  return names;
+}
+
+void LocalDatabase::truncate(std::string taskName, std::string objectName)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mIndexFd < 0) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the local database."));
+  }
+  // the data remains in the segments until the next compaction
+  writeIndexRecord(mIndexFd, taskName, objectName, Version{ now(), tombstone, 0, 0 });
+  if (auto task = mIndex.find(taskName); task != mIndex.end()) {
+    task->second.erase(objectName);
+    if (task->second.empty()) {
+      mIndex.erase(task);
+    }
+  }
+}
+
+std::optional<LocalDatabase::ObjectVersion> LocalDatabase::getLatest(const std::string& taskName,
+                                                                     const std::string& objectName)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  const auto* versions = findVersions(taskName, objectName);
+  if (versions == nullptr) {
+    return std::nullopt;
+  }
+  return view(versions->back());
+}
+
+std::vector<LocalDatabase::ObjectVersion> LocalDatabase::getHistory(const std::string& taskName,
+                                                                    const std::string& objectName, uint64_t from,
+                                                                    uint64_t to)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<ObjectVersion> history;
+  if (const auto* versions = findVersions(taskName, objectName)) {
+    for (const auto& version : *versions) {
+      if (version.timestamp >= from && version.timestamp <= to) {
+        history.push_back(view(version));
+      }
+    }
+  }
+  return history;
+}
+
+std::unique_ptr<MonitorObject> LocalDatabase::deserialize(const ObjectVersion& version)
+{
+  TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(version.size), const_cast<char*>(version.data), kFALSE);
+  auto* object = static_cast<TObject*>(buffer.ReadObjectAny(TObject::Class()));
+  auto* mo = dynamic_cast<MonitorObject*>(object);
+  if (mo == nullptr) {
+    delete object;
+    return nullptr;
+  }
+  mo->setIsOwner(true);
+  return std::unique_ptr<MonitorObject>(mo);
+}
+
+void LocalDatabase::compact(size_t keepVersions)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mIndexFd < 0) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the local database."));
+  }
+  keepVersions = std::max<size_t>(keepVersions, 1);
+
+  // The kept versions are copied to new segments, listed in a new index which replaces the current one once complete.
+  // If it is interrupted, the new segments are deleted when the database is opened again.
+  closeSegment();
+  uint32_t firstNewSegment = mNextSegment;
+  std::string compactedIndexPath = mDirectory + compactedIndexFileName;
+  int compactedIndexFd = ::open(compactedIndexPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (compactedIndexFd < 0) {
+    throwSystemError("Failed to create " + compactedIndexPath);
+  }
+  std::map<std::string, std::map<std::string, std::vector<Version>>> compacted;
+  size_t before = 0, after = 0;
+  try {
+    for (const auto& [taskName, objects] : mIndex) {
+      for (const auto& [objectName, versions] : objects) {
+        auto& kept = compacted[taskName][objectName];
+        before += versions.size();
+        for (size_t i = versions.size() > keepVersions ? versions.size() - keepVersions : 0; i < versions.size(); i++) {
+          ObjectVersion old = view(versions[i]);
+          Version moved = append(old.data, old.size, old.timestamp);
+          writeIndexRecord(compactedIndexFd, taskName, objectName, moved);
+          kept.push_back(moved);
+          after++;
+        }
+      }
+    }
+    for (const auto& [number, segment] : mSegments) {
+      if (number >= firstNewSegment && segment.used > 0 && ::msync(segment.data, segment.used, MS_SYNC) != 0) {
+        throwSystemError("Failed to write the segment " + getSegmentPath(number));
+      }
+    }
+    if (::fsync(compactedIndexFd) != 0) {
+      throwSystemError("Failed to write " + compactedIndexPath);
+    }
+    if (::rename(compactedIndexPath.c_str(), (mDirectory + indexFileName).c_str()) != 0) {
+      throwSystemError("Failed to replace the index of " + mDirectory);
+    }
+  } catch (...) {
+    // the current index and segments remain in use, the new segments must not be appended to
+    ::close(compactedIndexFd);
+    ::unlink(compactedIndexPath.c_str());
+    discardSegments(firstNewSegment);
+    throw;
+  }
+  ::close(compactedIndexFd);
+
+  std::string indexPath = mDirectory + indexFileName;
+  ::close(mIndexFd);
+  mIndexFd = ::open(indexPath.c_str(), O_WRONLY | O_APPEND);
+  if (mIndexFd < 0) {
+    throwSystemError("Failed to open " + indexPath);
+  }
+  mIndex = std::move(compacted);
+
+  for (auto segment = mSegments.begin(); segment != mSegments.end() && segment->first < firstNewSegment;) {
+    if (segment->second.data != nullptr) {
+      ::munmap(segment->second.data, segment->second.mapped);
+    }
+    ::unlink(getSegmentPath(segment->first).c_str());
+    segment = mSegments.erase(segment);
+  }
+  QcInfoLogger::GetInstance() << "Local database compacted, " << after << " versions kept out of " << before
+                              << infologger::endm;
+}
+
+void LocalDatabase::sync()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (const auto& [number, segment] : mSegments) {
+    if (segment.used > 0 && ::msync(segment.data, segment.used, MS_SYNC) != 0) {
+      throwSystemError("Failed to write the segment " + getSegmentPath(number));
+    }
+  }
+  if (mIndexFd >= 0 && ::fsync(mIndexFd) != 0) {
+    throwSystemError("Failed to write the index of " + mDirectory);
+  }
+}
+
+std::string LocalDatabase::getSegmentPath(uint32_t number) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "/segment-%08u.dat", number);
+  return mDirectory + name;
+}
+
+LocalDatabase::Version LocalDatabase::append(const char* data, size_t size, uint64_t timestamp)
+{
+  auto current = mSegments.find(mCurrentSegment);
+  if (current == mSegments.end() || current->second.used + size > current->second.mapped) {
+    closeSegment();
+    startSegment(std::max(mSegmentSize, size));
+    current = mSegments.find(mCurrentSegment);
+  }
+  Segment& segment = current->second;
+  std::memcpy(segment.data + segment.used, data, size);
+  Version version{ timestamp, mCurrentSegment, segment.used, size };
+  segment.used += size;
+  return version;
+}
+
+void LocalDatabase::startSegment(size_t capacity)
+{
+  uint32_t number = mNextSegment++;
+  std::string path = getSegmentPath(number);
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throwSystemError("Failed to create " + path);
+  }
+  // The disk space is reserved now, a full disk is thus reported here rather than by a SIGBUS when writing to the
+  // mapping. What is not used is given back when the segment is closed.
+  if (int error = ::posix_fallocate(fd, 0, capacity); error != 0) {
+    ::close(fd);
+    ::unlink(path.c_str());
+    errno = error;
+    throwSystemError("Failed to allocate " + path);
+  }
+  void* data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    ::unlink(path.c_str());
+    throwSystemError("Failed to map " + path);
+  }
+  Segment segment;
+  segment.data = static_cast<char*>(data);
+  segment.mapped = capacity;
+  segment.fd = fd;
+  mSegments[number] = segment;
+  mCurrentSegment = number;
+}
+
+void LocalDatabase::closeSegment()
+{
+  auto current = mSegments.find(mCurrentSegment);
+  mCurrentSegment = noSegment;
+  if (current == mSegments.end() || current->second.fd < 0) {
+    return;
+  }
+  // The pages beyond the data are never accessed, the mapping can thus outlive the end of the file.
+  if (::ftruncate(current->second.fd, current->second.used) != 0) {
+    QcInfoLogger::GetInstance() << "Failed to truncate the segment " << getSegmentPath(current->first) << " : "
+                                << std::strerror(errno) << infologger::endm;
+  }
+  ::close(current->second.fd);
+  current->second.fd = -1;
+}
+
+void LocalDatabase::discardSegments(uint32_t first)
+{
+  closeSegment();
+  for (auto segment = mSegments.lower_bound(first); segment != mSegments.end();) {
+    if (segment->second.data != nullptr) {
+      ::munmap(segment->second.data, segment->second.mapped);
+    }
+    ::unlink(getSegmentPath(segment->first).c_str());
+    segment = mSegments.erase(segment);
+  }
+  mNextSegment = first;
+}
+
+void LocalDatabase::writeIndexRecord(int fd, const std::string& taskName, const std::string& objectName,
+                                     const Version& version)
+{
+  if (taskName.size() > std::numeric_limits<uint16_t>::max() ||
+      objectName.size() > std::numeric_limits<uint16_t>::max()) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Task or object name too long : " + objectName));
+  }
+  IndexRecord record{ version.timestamp, version.offset, version.size, version.segment,
+                      static_cast<uint16_t>(taskName.size()), static_cast<uint16_t>(objectName.size()) };
+  // a single write, appended atomically
+  std::string buffer(reinterpret_cast<const char*>(&record), sizeof(record));
+  buffer += taskName;
+  buffer += objectName;
+  if (::write(fd, buffer.data(), buffer.size()) != static_cast<ssize_t>(buffer.size())) {
+    throwSystemError("Failed to write the index of " + mDirectory);
+  }
+}
+
+LocalDatabase::ObjectVersion LocalDatabase::view(const Version& version) const
+{
+  return ObjectVersion{ version.timestamp, mSegments.at(version.segment).data + version.offset, version.size };
+}
+
+const std::vector<LocalDatabase::Version>* LocalDatabase::findVersions(const std::string& taskName,
+                                                                       const std::string& objectName) const
+{
+  auto task = mIndex.find(taskName);
+  if (task == mIndex.end()) {
+    return nullptr;
+  }
+  auto object = task->second.find(objectName);
+  return object != task->second.end() && !object->second.empty() ? &object->second : nullptr;
+}
+
+} // namespace o2::quality_control::repository
@@ -0,0 +1,156 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   MonitorObjectsSerializer.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/MonitorObjectsSerializer.h"
+
+#include <cstring>
+// O2
+#include "Common/Exceptions.h"
+#include "Framework/DataRefUtils.h"
+#include "Headers/DataHeader.h"
+
+using namespace o2::framework;
+using namespace AliceO2::Common;
+
+namespace o2::quality_control::core
+{
+
+// Layout of the buffer : magic, version, number of objects, then an (offset, size) pair per object and the objects.
+// The objects are written with the ROOT buffer map reset, so that each of them can be read on its own. The offsets are
+// absolute, because ROOT refers to the already streamed classes by their absolute position in the buffer.
+namespace
+{
+const size_t headerSize = 3 * sizeof(UInt_t);
+const size_t tableEntrySize = 2 * sizeof(ULong64_t);
+const Int_t initialBufferSize = 64 * 1024;
+} // namespace
+
+MonitorObjectsSerializer::MonitorObjectsSerializer() : mBuffer(TBuffer::kWrite, initialBufferSize) {}
+
+const TBufferFile& MonitorObjectsSerializer::serialize(const TObjArray& objects)
+{
+  // the memory of the previous serializations is kept, only the position and the map of the streamed objects are reset
+  mBuffer.Reset();
+  UInt_t numberObjects = objects.GetEntriesFast();
+  mBuffer.WriteUInt(magic);
+  mBuffer.WriteUInt(version);
+  mBuffer.WriteUInt(numberObjects);
+
+  // The table is filled once the sizes are known.
+  Int_t tableStart = mBuffer.Length();
+  for (UInt_t i = 0; i < numberObjects; i++) {
+    mBuffer.WriteULong64(0);
+    mBuffer.WriteULong64(0);
+  }
+
+  std::vector<std::pair<ULong64_t, ULong64_t>> offsets;
+  offsets.reserve(numberObjects);
+  for (UInt_t i = 0; i < numberObjects; i++) {
+    mBuffer.ResetMap();
+    ULong64_t start = mBuffer.Length();
+    mBuffer.WriteObject(objects.UncheckedAt(i));
+    offsets.emplace_back(start, mBuffer.Length() - start);
+  }
+
+  Int_t end = mBuffer.Length();
+  mBuffer.SetBufferOffset(tableStart);
+  for (const auto& [offset, size] : offsets) {
+    mBuffer.WriteULong64(offset);
+    mBuffer.WriteULong64(size);
+  }
+  mBuffer.SetBufferOffset(end);
+  return mBuffer;
+}
+
+void MonitorObjectsSerializer::send(DataAllocator& outputs, const Output& output) const
+{
+  auto message = outputs.make<char>(output, mBuffer.Length());
+  std::memcpy(message.data(), mBuffer.Buffer(), mBuffer.Length());
+}
+
+std::unique_ptr<TObjArray> MonitorObjectsSerializer::deserialize(const DataRef& ref)
+{
+  MonitorObjectsView view(ref);
+  auto array = std::make_unique<TObjArray>();
+  array->SetOwner(true);
+  for (size_t i = 0; i < view.size(); i++) {
+    if (auto mo = view.get(i)) {
+      array->Add(mo.release());
+    }
+  }
+  return array;
+}
+
+MonitorObjectsView::MonitorObjectsView(const DataRef& ref)
+{
+  const auto* header = o2::header::get<header::DataHeader*>(ref.header);
+  if (header == nullptr) {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Received a message without DataHeader"));
+  }
+  if (header->payloadSerializationMethod == o2::header::gSerializationMethodROOT) {
+    mArray = DataRefUtils::as<TObjArray>(ref);
+    mArray->SetOwner(false);
+    return;
+  }
+
+  mPayload = const_cast<char*>(ref.payload);
+  mPayloadSize = header->payloadSize;
+  TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(mPayloadSize), mPayload, kFALSE);
+  UInt_t magic = 0, version = 0, numberObjects = 0;
+  if (mPayloadSize >= headerSize) {
+    buffer.ReadUInt(magic);
+    buffer.ReadUInt(version);
+    buffer.ReadUInt(numberObjects);
+  }
+  if (magic != MonitorObjectsSerializer::magic || version != MonitorObjectsSerializer::version ||
+      headerSize + static_cast<size_t>(numberObjects) * tableEntrySize > mPayloadSize) {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Received a message which does not contain MonitorObjects"));
+  }
+  mOffsets.resize(numberObjects);
+  for (auto& [offset, size] : mOffsets) {
+    buffer.ReadULong64(offset);
+    buffer.ReadULong64(size);
+    if (offset + size > mPayloadSize) {
+      BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Received a corrupted message of MonitorObjects"));
+    }
+  }
+}
+
+size_t MonitorObjectsView::size() const
+{
+  return mArray ? mArray->GetEntriesFast() : mOffsets.size();
+}
+
+std::unique_ptr<MonitorObject> MonitorObjectsView::get(size_t index)
+{
+  TObject* object = nullptr;
+  if (mArray) {
+    object = mArray->RemoveAt(index);
+  } else {
+    TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(mPayloadSize), mPayload, kFALSE);
+    buffer.SetBufferOffset(static_cast<Int_t>(mOffsets.at(index).first));
+    object = static_cast<TObject*>(buffer.ReadObjectAny(TObject::Class()));
+  }
+
+  auto* mo = dynamic_cast<MonitorObject*>(object);
+  if (mo == nullptr) {
+    delete object;
+    return nullptr;
+  }
+  mo->setIsOwner(true); // whatever the sender had, the encapsulated object was deserialized for us
+  return std::unique_ptr<MonitorObject>(mo);
+}
+
+} // namespace o2::quality_control::core
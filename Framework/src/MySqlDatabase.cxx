@@ -4,7 +4,12 @@
 ///
 
 // std
+#include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+// boost
+#include <boost/exception/diagnostic_information.hpp>
 // ROOT
 #include "TMessage.h"
 #include "TMySQLResult.h"
@@ -24,38 +29,58 @@ using namespace o2::quality_control::core;
 namespace o2::quality_control::repository
 {
 
-MySqlDatabase::MySqlDatabase() : mServer(nullptr), queueSize(0) { lastStorage.reset(); }
+MySqlDatabase::MySqlDatabase()
+  : mServer(nullptr),
+    mWriterServer(nullptr),
+    mBatchSize(defaultBatchSize),
+    mBatchBytes(defaultBatchBytes),
+    mBatchTime(defaultBatchTime),
+    mMessage(kMESS_OBJECT),
+    mWriteScheduled(false),
+    mFlushRequested(false),
+    mStopping(false),
+    mFailedObjects(0)
+{
+}
 
 MySqlDatabase::~MySqlDatabase() { disconnect(); }
 
 void MySqlDatabase::connect(std::string host, std::string database, std::string username, std::string password)
 {
-  if (mServer) {
-    if (mServer->IsConnected()) {
-      mServer->Close();
-    }
-    delete mServer;
-    mServer = nullptr;
-  }
+  disconnect();
   stringstream connectionString;
   connectionString << "mysql://" << host << "/" << database;
   // Important as the agent can be inactive for more than 8 hours and Mysql will drop idle connections older than 8
   // hours
   connectionString << "?reconnect=1";
-  mServer = new TMySQLServer(connectionString.str().c_str(), username.c_str(), password.c_str());
-  if (!mServer || mServer->GetErrorCode()) {
-    string s = "Failed to connect to the database\n";
-    if (mServer->GetErrorCode()) {
-      s += mServer->GetErrorMsg();
+  // one connection for the readers, one for the writer thread
+  for (TMySQLServer** server : { &mServer, &mWriterServer }) {
+    *server = new TMySQLServer(connectionString.str().c_str(), username.c_str(), password.c_str());
+    if (!*server || (*server)->GetErrorCode()) {
+      string s = "Failed to connect to the database\n";
+      if (*server && (*server)->GetErrorCode()) {
+        s += (*server)->GetErrorMsg();
+      }
+      BOOST_THROW_EXCEPTION(FatalException() << errinfo_details(s));
     }
-    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details(s));
-  } else {
-    QcInfoLogger::GetInstance() << "Connected to the database" << infologger::endm;
   }
+  QcInfoLogger::GetInstance() << "Connected to the database" << infologger::endm;
+  mFailedObjects = 0;
+  mWriteError = nullptr;
+  mWriter = std::make_unique<core::ThreadPool>(1);
 }
 
 void MySqlDatabase::connect(const std::unordered_map<std::string, std::string>& config)
 {
+  if (config.count("batchSize")) {
+    mBatchSize = std::max<size_t>(std::stoul(config.at("batchSize")), 1);
+  }
+  if (config.count("batchBytes")) {
+    mBatchBytes = std::max<size_t>(std::stoul(config.at("batchBytes")), 1);
+  }
+  if (config.count("batchTime")) {
+    mBatchTime = std::chrono::milliseconds(std::stol(config.at("batchTime")));
+  }
   this->connect(config.at("host"),
                 config.at("name"),
                 config.at("username"),
@@ -64,100 +89,293 @@ void MySqlDatabase::connect(const std::unordered_map<std::string, std::string>&
 
 void MySqlDatabase::prepareTaskDataContainer(std::string taskName)
 {
-  // one object per run
-  string query;
-  query += "CREATE TABLE IF NOT EXISTS `data_" + taskName +
-           "` (object_name CHAR(64), updatetime TIMESTAMP DEFAULT CURRENT_TIMESTAMP, data LONGBLOB, size INT, run INT, "
-           "fill INT, PRIMARY KEY(object_name, run)) ENGINE=MyISAM";
-  if (!execute(query)) {
+  if (!execute(dataTableCreation(taskName))) {
     BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Failed to create data table"));
   } else {
     QcInfoLogger::GetInstance() << "Create data table for task " << taskName << infologger::endm;
   }
 }
 
+std::string MySqlDatabase::dataTableCreation(const std::string& taskName)
+{
+  // one object per run
+  return "CREATE TABLE IF NOT EXISTS `data_" + taskName +
+         "` (object_name CHAR(64), updatetime TIMESTAMP DEFAULT CURRENT_TIMESTAMP, data LONGBLOB, size INT, run INT, "
+         "fill INT, PRIMARY KEY(object_name, run)) ENGINE=MyISAM";
+}
+
 void MySqlDatabase::store(std::shared_ptr<o2::quality_control::core::MonitorObject> mo)
 {
-  // TODO we take ownership here to delete later -> clearly to be improved
-  // we execute grouped insertions. Here we just register that we should keep this mo in memory.
-  mObjectsQueue[mo->getTaskName()].push_back(mo);
-  queueSize++;
-  if (queueSize > 4 || lastStorage.getTime() > 10 /*sec*/) { // TODO use a configuration to set the max limits
-    storeQueue();
+  if (!mWriter) {
+    BOOST_THROW_EXCEPTION(DatabaseException() << errinfo_details("Not connected to the database. Do not store."));
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  // if the batch is full, the writer is still busy with the previous one
+  mBatchWritten.wait(lock, [this] { return !isFull(mPending); });
+
+  mMessage.Reset();
+  mMessage.WriteObjectAny(mo.get(), mo->IsA());
+  auto& task = mPending.tasks[mo->getTaskName()];
+  task.names.push_back(mo->getName());
+  task.data.insert(task.data.end(), mMessage.Buffer(), mMessage.Buffer() + mMessage.Length());
+  task.ends.push_back(task.data.size());
+  if (mPending.objects == 0) {
+    mPending.firstObject = std::chrono::steady_clock::now();
+  }
+  mPending.objects++;
+  mPending.bytes += mMessage.Length();
+  if (!mWriteScheduled) {
+    mWriteScheduled = true;
+    mWriter->submit([this] { writePending(); });
+  } else if (isFull(mPending)) {
+    mBatchReady.notify_one();
   }
 }
 
-void MySqlDatabase::storeQueue()
+void MySqlDatabase::flush()
 {
-  QcInfoLogger::GetInstance() << "Database queue will now be processed (" << queueSize << " objects)"
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (mPending.objects > 0) {
+    mFlushRequested = true;
+    mBatchReady.notify_one();
+  }
+  mBatchWritten.wait(lock, [this] { return !mWriteScheduled; });
+  if (mWriteError) {
+    std::rethrow_exception(std::exchange(mWriteError, nullptr));
+  }
+}
+
+unsigned long MySqlDatabase::getNumberOfFailedObjects()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFailedObjects;
+}
+
+bool MySqlDatabase::isFull(const Batch& batch) const
+{
+  return batch.objects >= mBatchSize || batch.bytes >= mBatchBytes;
+}
+
+void MySqlDatabase::writePending()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto deadline = mPending.firstObject + mBatchTime;
+  mBatchReady.wait_until(lock, deadline, [this, deadline] {
+    return mStopping || mFlushRequested || isFull(mPending) || std::chrono::steady_clock::now() >= deadline;
+  });
+
+  // the buffers of the batch written previously are reused for the next one
+  std::swap(mPending, mWriting);
+  lock.unlock();
+  mBatchWritten.notify_all(); // room for the next batch
+  std::exception_ptr error;
+  size_t failed = writeBatch(mWriting, error);
+  lock.lock();
+
+  mFailedObjects += failed;
+  if (error && !mWriteError) {
+    mWriteError = error;
+  }
+  if (mPending.objects > 0) {
+    mWriter->submit([this] { writePending(); });
+  } else {
+    mWriteScheduled = false;
+    mFlushRequested = false;
+    mBatchWritten.notify_all();
+  }
+}
+
+size_t MySqlDatabase::writeBatch(Batch& batch, std::exception_ptr& error)
+{
+  QcInfoLogger::GetInstance() << "Database queue will now be processed (" << batch.objects << " objects)"
                               << infologger::endm;
 
-  for (auto& kv : mObjectsQueue) {
-    storeForTask(kv.first);
+  size_t failed = 0;
+  for (auto& [taskName, objects] : batch.tasks) {
+    if (objects.names.empty()) {
+      continue;
+    }
+    try {
+      writeTask(taskName, objects);
+    } catch (...) {
+      // the objects are lost, the error is reported by the next flush
+      QcInfoLogger::GetInstance() << "Failed to store " << objects.names.size() << " objects of task " << taskName
+                                  << " : " << boost::current_exception_diagnostic_information() << infologger::endm;
+      mInsertStatements.erase(taskName); // they are prepared again for the next batch, e.g. after a reconnection
+      failed += objects.names.size();
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+    objects.names.clear();
+    objects.ends.clear();
+    objects.data.clear();
   }
-  mObjectsQueue.clear();
-  queueSize = 0;
-  lastStorage.reset();
+  batch.objects = 0;
+  batch.bytes = 0;
+  return failed;
 }
 
-void MySqlDatabase::storeForTask(std::string taskName)
+int MySqlDatabase::blobClass(size_t size)
 {
-  std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> objects = mObjectsQueue[taskName];
+  // as TMySQLStatement::SetBinary, which declares a parameter of size bytes as a blob of at least size+1 bytes
+  if (size < 65525) {
+    return 0; // BLOB
+  }
+  return size < 16777205 ? 1 : 2; // MEDIUM BLOB, LONG BLOB
+}
 
-  if (objects.size() == 0) {
-    return;
+void MySqlDatabase::writeTask(const std::string& taskName, const TaskBatch& objects)
+{
+  // the objects of each blob class, in the order they were stored
+  std::map<int, std::vector<size_t>> classes;
+  for (size_t i = 0; i < objects.names.size(); i++) {
+    size_t begin = i == 0 ? 0 : objects.ends[i - 1];
+    classes[blobClass(objects.ends[i] - begin)].push_back(i);
   }
 
-  cout << "** Store for task " << taskName << endl;
-  cout << "        # objects : " << objects.size() << endl;
+  for (const auto& [sizeClass, indices] : classes) {
+    size_t written = 0;
+    while (written < indices.size()) {
+      // the longest statement which fits in the rest of the objects, thus at most log2(maxRowsPerStatement)+1
+      // statements are prepared per blob class for a table
+      size_t rows = maxRowsPerStatement;
+      while (rows > indices.size() - written) {
+        rows /= 2;
+      }
+      TSQLStatement* statement = getInsertStatement(taskName, sizeClass, rows);
+      for (size_t row = 0; row < rows; row++, written++) {
+        size_t i = indices[written];
+        size_t begin = i == 0 ? 0 : objects.ends[i - 1];
+        Long_t size = objects.ends[i] - begin;
+        statement->SetString(3 * row, objects.names[i].c_str());
+        // bound at its actual size, the buffer of the parameter grows only as much as the largest object bound to it
+        statement->SetBinary(3 * row + 1, const_cast<char*>(objects.data.data() + begin), size, size);
+        statement->SetInt(3 * row + 2, size);
+      }
+      // executes the statement with these parameters, it stays ready for the next ones
+      if (!statement->NextIteration()) {
+        BOOST_THROW_EXCEPTION(DatabaseException()
+                              << errinfo_details("Encountered an error when inserting objects in MySqlDatabase")
+                              << errinfo_db_message(statement->GetErrorMsg())
+                              << errinfo_db_errno(statement->GetErrorCode()));
+      }
+    }
+  }
+}
 
-  // build statement string
-  string query;
-  query +=
-    "REPlACE INTO `data_" + taskName + "` (object_name, data, size, run, fill) values (?,?,octet_length(data),?,?)";
+TSQLStatement* MySqlDatabase::getInsertStatement(const std::string& taskName, int blobClass, size_t rows)
+{
+  auto& statement = mInsertStatements[taskName][{ blobClass, rows }];
+  if (statement) {
+    return statement.get();
+  }
 
-  // Prepare statement
-  TMySQLStatement* statement;
-  // try to insert if it fails we check whether the table is there or not and create it if needed
-  statement = (TMySQLStatement*)mServer->Statement(query.c_str());
-  if (mServer->IsError() && mServer->GetErrorCode() == 1146) { // table does not exist
-    // try to create the table
-    prepareTaskDataContainer(taskName);
-    statement = (TMySQLStatement*)mServer->Statement(query.c_str());
+  string query = "REPLACE INTO `data_" + taskName + "` (object_name, data, size, run, fill) VALUES (?,?,?,0,0)";
+  for (size_t row = 1; row < rows; row++) {
+    query += ",(?,?,?,0,0)";
   }
-  if (mServer->IsError()) {
+  // try to prepare it, if it fails we check whether the table is there or not and create it if needed
+  statement.reset(mWriterServer->Statement(query.c_str()));
+  if (mWriterServer->IsError() && mWriterServer->GetErrorCode() == 1146) { // table does not exist
+    if (!mWriterServer->Exec(dataTableCreation(taskName).c_str())) {
+      BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("Failed to create data table"));
+    }
+    QcInfoLogger::GetInstance() << "Create data table for task " << taskName << infologger::endm;
+    statement.reset(mWriterServer->Statement(query.c_str()));
+  }
+  if (mWriterServer->IsError() || !statement) {
+    statement.reset();
     BOOST_THROW_EXCEPTION(DatabaseException()
                           << errinfo_details("Encountered an error when creating statement in MySqlDatabase")
-                          << errinfo_db_message(mServer->GetErrorMsg()) << errinfo_db_errno(mServer->GetErrorCode()));
+                          << errinfo_db_message(mWriterServer->GetErrorMsg())
+                          << errinfo_db_errno(mWriterServer->GetErrorCode()));
   }
+  statement->NextIteration(); // the first iteration only opens the setting of the parameters
+  return statement.get();
+}
 
-  // Assign data
-  TMessage message(kMESS_OBJECT);
-  for (auto mo : objects) {
-    message.Reset();
-    message.WriteObjectAny(mo.get(), mo->IsA());
-    statement->NextIteration();
-    statement->SetString(0, mo->getName().c_str());
-    statement->SetBinary(1, message.Buffer(), message.Length(), message.Length());
-    statement->SetInt(2, 0);
-    statement->SetInt(3, 0);
+void MySqlDatabase::stopWriter()
+{
+  if (!mWriter) {
+    return;
+  }
+  {
+    // the pending objects are written without waiting
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStopping = true;
+    mBatchReady.notify_one();
+    mBatchWritten.wait(lock, [this] { return !mWriteScheduled; });
+  }
+  mWriter.reset();
+  mStopping = false;
+  if (mWriteError) {
+    QcInfoLogger::GetInstance() << mFailedObjects << " objects could not be stored in the database" << infologger::endm;
+    mWriteError = nullptr;
   }
-  statement->Process();
-  delete statement;
-
-  //  for (auto mo : objects) {
-  //    delete mo;
-  //  }
-  objects.clear();
 }
 
 o2::quality_control::core::MonitorObject* MySqlDatabase::retrieve(std::string taskName, std::string objectName)
 {
-  string query;
-  TMySQLStatement* statement = nullptr;
+  auto objects = selectObjects(taskName, &objectName, 1);
+  return objects.empty() ? nullptr : objects.front().release(); // Consider only the first result
+}
 
-  query += "SELECT object_name, data, updatetime, run, fill FROM data_" + taskName + " WHERE object_name = ?";
-  statement = (TMySQLStatement*)mServer->Statement(query.c_str());
+std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>>
+  MySqlDatabase::retrieveMany(std::string taskName, const std::vector<std::string>& objectNames)
+{
+  // one query per chunk of names, to stay far below the limit of placeholders of a statement
+  const size_t chunkSize = 1000;
+  std::unordered_map<std::string, std::shared_ptr<o2::quality_control::core::MonitorObject>> objectsByName;
+  for (size_t first = 0; first < objectNames.size(); first += chunkSize) {
+    size_t count = std::min(chunkSize, objectNames.size() - first);
+    for (auto& mo : selectObjects(taskName, objectNames.data() + first, count)) {
+      mo->setIsOwner(true); // the task streamed it without the ownership
+      objectsByName.emplace(mo->getName(), std::move(mo)); // Consider only the first result of each object
+    }
+  }
+
+  // in the order of the request
+  std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> objects;
+  for (const auto& objectName : objectNames) {
+    if (auto found = objectsByName.find(objectName); found != objectsByName.end()) {
+      objects.push_back(found->second);
+    }
+  }
+  return objects;
+}
+
+std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> MySqlDatabase::retrieveAll(std::string taskName)
+{
+  std::vector<std::shared_ptr<o2::quality_control::core::MonitorObject>> objects;
+  std::unordered_set<std::string> names;
+  for (auto& mo : selectObjects(taskName, nullptr, 0)) {
+    mo->setIsOwner(true); // the task streamed it without the ownership
+    if (names.insert(mo->getName()).second) { // Consider only the first result of each object
+      objects.emplace_back(std::move(mo));
+    }
+  }
+  return objects;
+}
+
+std::vector<std::unique_ptr<o2::quality_control::core::MonitorObject>>
+  MySqlDatabase::selectObjects(const std::string& taskName, const std::string* objectNames, size_t count)
+{
+  std::vector<std::unique_ptr<o2::quality_control::core::MonitorObject>> objects;
+  if (objectNames != nullptr && count == 0) {
+    return objects;
+  }
+
+  string query = "SELECT object_name, data, updatetime, run, fill FROM data_" + taskName;
+  if (objectNames != nullptr) {
+    query += " WHERE object_name IN (?";
+    for (size_t i = 1; i < count; i++) {
+      query += ",?";
+    }
+    query += ")";
+  }
+  TMySQLStatement* statement = (TMySQLStatement*)mServer->Statement(query.c_str());
   if (mServer->IsError()) {
     if (statement) {
       delete statement;
@@ -166,8 +384,12 @@ o2::quality_control::core::MonitorObject* MySqlDatabase::retrieve(std::string ta
                           << errinfo_details("Encountered an error when creating statement in MySqlDatabase")
                           << errinfo_db_message(mServer->GetErrorMsg()) << errinfo_db_errno(mServer->GetErrorCode()));
   }
-  statement->NextIteration();
-  statement->SetString(0, objectName.c_str());
+  if (objectNames != nullptr) {
+    statement->NextIteration();
+    for (size_t i = 0; i < count; i++) {
+      statement->SetString(i, objectNames[i].c_str());
+    }
+  }
 
   if (!(statement->Process() && statement->StoreResult())) {
     delete statement;
@@ -177,8 +399,8 @@ o2::quality_control::core::MonitorObject* MySqlDatabase::retrieve(std::string ta
                           << errinfo_db_message(mServer->GetErrorMsg()) << errinfo_db_errno(mServer->GetErrorCode()));
   }
 
-  o2::quality_control::core::MonitorObject* mo = nullptr;
-  if (statement->NextResultRow()) { // Consider only the first result
+  TMessage mess(kMESS_OBJECT);
+  while (statement->NextResultRow()) {
     string name = statement->GetString(0);
     void* blob = nullptr;
     Long_t blobSize;
@@ -188,20 +410,20 @@ o2::quality_control::core::MonitorObject* MySqlDatabase::retrieve(std::string ta
     int run = statement->IsNull(3) ? -1 : statement->GetInt(3);
     int fill = statement->IsNull(4) ? -1 : statement->GetInt(4);
 
-    TMessage mess(kMESS_OBJECT);
     mess.SetBuffer(blob, blobSize, kFALSE);
     mess.SetReadMode();
     mess.Reset();
     try {
-      mo = (o2::quality_control::core::MonitorObject*)(mess.ReadObjectAny(mess.GetClass()));
+      objects.emplace_back((o2::quality_control::core::MonitorObject*)(mess.ReadObjectAny(mess.GetClass())));
     } catch (...) {
       QcInfoLogger::GetInstance() << "Node: unable to parse TObject from MySQL" << infologger::endm;
+      delete statement;
       throw;
     }
   }
   delete statement;
 
-  return mo;
+  return objects;
 }
 
 std::string MySqlDatabase::retrieveJson(std::string taskName, std::string objectName)
@@ -218,14 +440,17 @@ std::string MySqlDatabase::retrieveJson(std::string taskName, std::string object
 
 void MySqlDatabase::disconnect()
 {
-  storeQueue();
-
-  if (mServer) {
-    if (mServer->IsConnected()) {
-      mServer->Close();
+  stopWriter();
+  mInsertStatements.clear();
+
+  for (TMySQLServer** server : { &mServer, &mWriterServer }) {
+    if (*server) {
+      if ((*server)->IsConnected()) {
+        (*server)->Close();
+      }
+      delete *server;
+      *server = nullptr;
     }
-    delete mServer;
-    mServer = nullptr;
   }
 }
 
@@ -300,6 +525,7 @@ std::vector<std::string> MySqlDatabase::getListOfTasksWithPublications()
 
 void MySqlDatabase::truncate(std::string taskName, std::string objectName)
 {
+  flush(); // otherwise a pending version would be written afterwards
   string queryString = string("delete ignore from `data_") + taskName + "` where object_name='" + objectName + "'";
 
   if (!execute(queryString)) {
@@ -0,0 +1,230 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ObjectGenerator.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/ObjectGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+// ROOT
+#include <TBufferFile.h>
+#include <TDirectory.h>
+#include <TGraph.h>
+#include <TH2F.h>
+#include <TH3F.h>
+#include <TProfile.h>
+#include <TTree.h>
+// O2
+#include <Common/Exceptions.h>
+
+using namespace AliceO2::Common;
+
+namespace o2::quality_control::core
+{
+
+namespace
+{
+// numbers of cells of the objects built to find the size of a cell
+constexpr size_t calibrationCells[] = { 4000, 40000 };
+
+// position of the center of the cell i (from 1) out of n, from -0.5 to 0.5
+double position(size_t i, size_t n) { return (i - 0.5) / n - 0.5; }
+} // namespace
+
+ObjectGenerator::ObjectGenerator(unsigned int seed) : mGenerator(seed)
+{
+}
+
+TObject* ObjectGenerator::generate(Type type, const std::string& name, size_t sizeBytes, Content content)
+{
+  // The size is linear in the number of cells stored, the under- and overflow bins of the histograms included.
+  auto calibration = mCalibrations.find({ type, content });
+  if (calibration == mCalibrations.end()) {
+    double cells[2], sizes[2];
+    for (int i = 0; i < 2; i++) {
+      auto dimensions = getDimensions(type, calibrationCells[i], false);
+      std::unique_ptr<TObject> object(build(type, name, dimensions, content));
+      cells[i] = getStoredCells(type, dimensions);
+      sizes[i] = getSerializedSize(*object);
+    }
+    double cellSize = (sizes[1] - sizes[0]) / (cells[1] - cells[0]);
+    double overhead = sizes[0] - cellSize * cells[0];
+    calibration = mCalibrations.emplace(std::make_pair(type, content), std::make_pair(overhead, cellSize)).first;
+  }
+
+  auto [overhead, cellSize] = calibration->second;
+  return build(type, name, getDimensions(type, (sizeBytes - overhead) / cellSize, true), content);
+}
+
+TObject* ObjectGenerator::generateCells(Type type, const std::string& name, size_t cells, Content content)
+{
+  return build(type, name, getDimensions(type, cells, false), content);
+}
+
+ObjectGenerator::Dimensions ObjectGenerator::getDimensions(Type type, double cells, bool withOverflows)
+{
+  int numberDimensions = type == Type::TH2F ? 2 : type == Type::TH3F ? 3 : 1;
+  double overflows = withOverflows && type != Type::TGraph && type != Type::TTree ? 2 : 0;
+  // as square as possible, the last dimension takes what remains
+  Dimensions dimensions{ 1, 1, 1 };
+  for (int i = 0; i < numberDimensions; i++) {
+    double side = std::pow(std::max(cells, 1.0), 1.0 / (numberDimensions - i));
+    dimensions[i] = std::max<long>(std::lround(side - overflows), 1);
+    cells /= dimensions[i] + overflows;
+  }
+  return dimensions;
+}
+
+size_t ObjectGenerator::getStoredCells(Type type, const Dimensions& dimensions)
+{
+  if (type == Type::TGraph || type == Type::TTree) {
+    return dimensions[0];
+  }
+  size_t cells = 1;
+  for (int i = 0; i < (type == Type::TH2F ? 2 : type == Type::TH3F ? 3 : 1); i++) {
+    cells *= dimensions[i] + 2;
+  }
+  return cells;
+}
+
+TObject* ObjectGenerator::build(Type type, const std::string& name, const Dimensions& dimensions, Content content)
+{
+  TDirectory::TContext context(nullptr); // the objects are not attached to the current directory
+  size_t cells = dimensions[0];
+  int x = dimensions[0], y = dimensions[1], z = dimensions[2];
+
+  switch (type) {
+    case Type::TH1F: {
+      auto* histo = new TH1F(name.c_str(), name.c_str(), cells, 0, cells);
+      for (size_t bin = 1; bin <= cells; bin++) {
+        histo->SetBinContent(bin, value(content, std::abs(position(bin, cells))));
+      }
+      histo->ResetStats();
+      return histo;
+    }
+    case Type::TH2F: {
+      auto* histo = new TH2F(name.c_str(), name.c_str(), x, 0, x, y, 0, y);
+      for (int i = 1; i <= x; i++) {
+        for (int j = 1; j <= y; j++) {
+          histo->SetBinContent(i, j, value(content, std::hypot(position(i, x), position(j, y))));
+        }
+      }
+      histo->ResetStats();
+      return histo;
+    }
+    case Type::TH3F: {
+      auto* histo = new TH3F(name.c_str(), name.c_str(), x, 0, x, y, 0, y, z, 0, z);
+      for (int i = 1; i <= x; i++) {
+        for (int j = 1; j <= y; j++) {
+          for (int k = 1; k <= z; k++) {
+            histo->SetBinContent(i, j, k, value(content, std::hypot(position(i, x), position(j, y), position(k, z))));
+          }
+        }
+      }
+      histo->ResetStats();
+      return histo;
+    }
+    case Type::TProfile: {
+      auto* profile = new TProfile(name.c_str(), name.c_str(), cells, 0, cells);
+      for (size_t bin = 1; bin <= cells; bin++) {
+        double y = value(content, std::abs(position(bin, cells)));
+        if (y != 0) { // the empty bins stay empty, otherwise each one gets a single entry
+          profile->Fill(bin - 0.5, y);
+        }
+      }
+      return profile;
+    }
+    case Type::TGraph: {
+      auto* graph = new TGraph(cells);
+      graph->SetNameTitle(name.c_str(), name.c_str());
+      for (size_t point = 0; point < cells; point++) {
+        graph->SetPoint(point, point, value(content, std::abs(position(point + 1, cells))));
+      }
+      return graph;
+    }
+    case Type::TTree: {
+      // a few branches of basic types, the tree and its baskets are kept in memory
+      auto* tree = new TTree(name.c_str(), name.c_str());
+      Int_t id;
+      Float_t x, y;
+      tree->Branch("id", &id, "id/I");
+      tree->Branch("x", &x, "x/F");
+      tree->Branch("y", &y, "y/F");
+      for (size_t entry = 0; entry < cells; entry++) {
+        x = value(content, std::abs(position(entry + 1, cells)));
+        y = value(content, std::abs(position(entry + 1, cells)));
+        id = x != 0 ? entry : 0;
+        tree->Fill();
+      }
+      tree->ResetBranchAddresses();
+      return tree;
+    }
+  }
+  BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("unknown type of object"));
+}
+
+double ObjectGenerator::value(Content content, double distance)
+{
+  switch (content) {
+    case Content::Empty:
+      return 0;
+    case Content::Sparse:
+      return std::uniform_real_distribution<double>(0, 1)(mGenerator) < 0.01
+               ? std::uniform_real_distribution<double>(0, 1000)(mGenerator)
+               : 0;
+    case Content::Smooth:
+      return 1000 * std::exp(-std::pow(distance / 0.15, 2) / 2);
+    case Content::Random:
+      return std::uniform_real_distribution<double>(0, 1000)(mGenerator);
+  }
+  return 0;
+}
+
+size_t ObjectGenerator::getSerializedSize(const TObject& object)
+{
+  TBufferFile buffer(TBuffer::kWrite);
+  buffer.WriteObject(&object);
+  return buffer.Length();
+}
+
+ObjectGenerator::Type ObjectGenerator::getType(const std::string& name)
+{
+  static const std::map<std::string, Type> types = { { "TH1F", Type::TH1F },     { "TH2F", Type::TH2F },
+                                                     { "TH3F", Type::TH3F },     { "TProfile", Type::TProfile },
+                                                     { "TGraph", Type::TGraph }, { "TTree", Type::TTree } };
+  auto type = types.find(name);
+  if (type == types.end()) {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details(
+                            "the type of object must be TH1F, TH2F, TH3F, TProfile, TGraph or TTree (was: " + name +
+                            ")"));
+  }
+  return type->second;
+}
+
+ObjectGenerator::Content ObjectGenerator::getContent(const std::string& name)
+{
+  static const std::map<std::string, Content> contents = { { "empty", Content::Empty },
+                                                           { "sparse", Content::Sparse },
+                                                           { "smooth", Content::Smooth },
+                                                           { "random", Content::Random } };
+  auto content = contents.find(name);
+  if (content == contents.end()) {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details(
+                            "the content of object must be empty, sparse, smooth or random (was: " + name + ")"));
+  }
+  return content->second;
+}
+
+} // namespace o2::quality_control::core
@@ -0,0 +1,252 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ObjectMerger.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/ObjectMerger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+// ROOT
+#include <TClass.h>
+#include <TGraph.h>
+#include <TH1D.h>
+#include <TH1F.h>
+#include <TH2D.h>
+#include <TH2F.h>
+#include <TH3D.h>
+#include <TH3F.h>
+#include <TList.h>
+
+namespace o2::quality_control::core
+{
+
+namespace
+{
+
+bool sameAxis(const TAxis* a, const TAxis* b)
+{
+  if (a->GetNbins() != b->GetNbins() || a->GetXmin() != b->GetXmin() || a->GetXmax() != b->GetXmax()) {
+    return false;
+  }
+  // labelled bins are matched by label by TH1::Add and TH1::Merge, not by index
+  if (a->GetLabels() != nullptr || b->GetLabels() != nullptr) {
+    return false;
+  }
+  const TArrayD* aBins = a->GetXbins();
+  const TArrayD* bBins = b->GetXbins();
+  return aBins->GetSize() == bBins->GetSize() &&
+         std::equal(aBins->GetArray(), aBins->GetArray() + aBins->GetSize(), bBins->GetArray());
+}
+
+// Plain loops over contiguous arrays without aliasing, they are vectorized by the compiler.
+template <typename T>
+void addArrays(T* __restrict target, const T* __restrict update, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    target[i] += update[i];
+  }
+}
+
+template <typename T>
+void addAbsoluteArray(double* __restrict target, const T* __restrict update, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    target[i] += std::abs(static_cast<double>(update[i]));
+  }
+}
+
+template <typename TArrayType>
+void addBinsImpl(TH1* target, const TH1* update)
+{
+  auto* targetArray = dynamic_cast<TArrayType*>(target);
+  const auto* updateArray = dynamic_cast<const TArrayType*>(update);
+  size_t size = targetArray->GetSize();
+
+  double targetStats[TH1::kNstat] = { 0 };
+  double updateStats[TH1::kNstat] = { 0 };
+  target->GetStats(targetStats);
+  update->GetStats(updateStats);
+  double entries = target->GetEntries() + update->GetEntries();
+
+  // the squared weights, if any, are obtained from the contents before they are modified
+  if (update->GetSumw2N() > 0 && target->GetSumw2N() == 0) {
+    target->Sumw2();
+  }
+  if (target->GetSumw2N() > 0) {
+    if (update->GetSumw2N() > 0) {
+      addArrays(target->GetSumw2()->GetArray(), update->GetSumw2()->GetArray(), size);
+    } else {
+      // unweighted update, its squared errors are its contents
+      addAbsoluteArray(target->GetSumw2()->GetArray(), updateArray->GetArray(), size);
+    }
+  }
+  addArrays(targetArray->GetArray(), updateArray->GetArray(), size);
+
+  for (int i = 0; i < TH1::kNstat; i++) {
+    targetStats[i] += updateStats[i];
+  }
+  target->PutStats(targetStats);
+  target->SetEntries(entries);
+}
+
+} // namespace
+
+bool ObjectMerger::merge(const std::string& slot, TObject* target, TCollection& updates)
+{
+  if (target == nullptr) {
+    return false;
+  }
+
+  auto cached = mSlots.find(slot);
+  if (cached == mSlots.end() || cached->second.objectClass != target->IsA()) {
+    cached = mSlots.insert_or_assign(slot, Slot{ target->IsA(), resolve(target) }).first;
+  }
+  if (cached->second.method == Method::None) {
+    return false;
+  }
+  if (updates.GetEntries() == 0) {
+    return true;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  bool merged = merge(target, updates, cached->second.method);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  auto& statistics = mStatistics[target->ClassName()];
+  statistics.merges++;
+  statistics.objects += updates.GetEntries();
+  statistics.seconds += elapsed.count();
+  return merged;
+}
+
+std::string ObjectMerger::getStatisticsSummary() const
+{
+  std::ostringstream summary;
+  summary << std::fixed << std::setprecision(1);
+  for (const auto& [className, statistics] : mStatistics) {
+    if (summary.tellp() > 0) {
+      summary << ", ";
+    }
+    summary << className << " : " << statistics.objects << " objects in " << statistics.seconds * 1000 << " ms";
+  }
+  return summary.str();
+}
+
+ObjectMerger::Method ObjectMerger::resolve(const TObject* target)
+{
+  if (target == nullptr) {
+    return Method::None;
+  }
+  if (target->InheritsFrom(TH1::Class())) {
+    return Method::Add;
+  }
+  if (target->IsA()->GetMerge() != nullptr) {
+    return Method::Merge;
+  }
+  return Method::None;
+}
+
+bool ObjectMerger::merge(TObject* target, TCollection& updates, Method method)
+{
+  switch (method) {
+    case Method::Add: {
+      auto* histo = static_cast<TH1*>(target);
+      bool merged = true;
+      for (auto* object : updates) {
+        auto* update = dynamic_cast<TH1*>(object);
+        if (update == nullptr) {
+          merged = false;
+          continue;
+        }
+        if (addBins(histo, update)) {
+          continue;
+        }
+        // different binnings (e.g. extended axes) are not supported by Add, but by Merge
+        if (update->GetNcells() != histo->GetNcells() || !histo->Add(update)) {
+          TList list;
+          list.Add(update);
+          merged &= histo->Merge(&list) >= 0;
+        }
+      }
+      return merged;
+    }
+    case Method::Merge:
+      // the Merge methods return a negative value when they fail, e.g. on incompatible objects
+      return target->IsA()->GetMerge()(target, &updates, nullptr) >= 0;
+    case Method::None:
+    default:
+      return false;
+  }
+}
+
+bool ObjectMerger::addBins(TH1* target, const TH1* update)
+{
+  // Only the plain histogram classes, the derived ones (profiles, TH2Poly...) hold more than bin contents and weights.
+  TClass* histoClass = target->IsA();
+  if (update->IsA() != histoClass || target->GetNcells() != update->GetNcells()) {
+    return false;
+  }
+  bool isFloat = histoClass == TH1F::Class() || histoClass == TH2F::Class() || histoClass == TH3F::Class();
+  bool isDouble = histoClass == TH1D::Class() || histoClass == TH2D::Class() || histoClass == TH3D::Class();
+  if (!isFloat && !isDouble) {
+    return false;
+  }
+  // buffered (automatic binning) and averaged histograms need the logic of TH1::Add
+  if (target->GetBuffer() != nullptr || update->GetBuffer() != nullptr || target->TestBit(TH1::kIsAverage) ||
+      update->TestBit(TH1::kIsAverage)) {
+    return false;
+  }
+  if (!sameAxis(target->GetXaxis(), update->GetXaxis()) || !sameAxis(target->GetYaxis(), update->GetYaxis()) ||
+      !sameAxis(target->GetZaxis(), update->GetZaxis())) {
+    return false;
+  }
+
+  if (isFloat) {
+    addBinsImpl<TArrayF>(target, update);
+  } else {
+    addBinsImpl<TArrayD>(target, update);
+  }
+  return true;
+}
+
+bool ObjectMerger::isResettable(const TObject* object)
+{
+  return object != nullptr && (object->InheritsFrom(TH1::Class()) || object->InheritsFrom(TGraph::Class()) ||
+                               object->IsA()->GetResetAfterMerge() != nullptr);
+}
+
+bool ObjectMerger::reset(TObject* object)
+{
+  if (object == nullptr) {
+    return false;
+  }
+  if (auto* histo = dynamic_cast<TH1*>(object)) {
+    histo->Reset();
+    return true;
+  }
+  if (auto* graph = dynamic_cast<TGraph*>(object)) {
+    graph->Set(0);
+    return true;
+  }
+  if (auto resetAfterMerge = object->IsA()->GetResetAfterMerge()) {
+    resetAfterMerge(object, nullptr);
+    return true;
+  }
+  return false;
+}
+
+} // namespace o2::quality_control::core
@@ -16,6 +16,20 @@
 #include "QualityControl/ObjectsManager.h"
 #include "Common/Exceptions.h"
 #include "QualityControl/QcInfoLogger.h"
+#include <TArrayC.h>
+#include <TArrayD.h>
+#include <TArrayF.h>
+#include <TArrayI.h>
+#include <TArrayS.h>
+#include <TClass.h>
+#include <TGraph.h>
+#include <TH1.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+#include <functional>
+#include <optional>
+#include <string_view>
 
 using namespace o2::quality_control::core;
 using namespace AliceO2::Common;
@@ -38,13 +52,14 @@ void ObjectsManager::startPublishing(TObject* object, std::string objectName)
   auto* newObject = new MonitorObject(object, mTaskName);
   newObject->setIsOwner(false);
   mMonitorObjects.Add(newObject);
+  mMonitorObjectsIndex.emplace(newObject->getName(), newObject);
+  if (!objectName.empty()) {
+    mMonitorObjectsIndex.emplace(objectName, newObject);
+  }
 }
 
 Quality ObjectsManager::getQuality(std::string objectName)
 {
-  if (mMonitorObjects.FindObject(objectName.c_str())) {
-    BOOST_THROW_EXCEPTION(ObjectNotFoundError() << errinfo_object_name(objectName));
-  }
   MonitorObject* mo = getMonitorObject(objectName);
   return mo->getQuality();
 }
@@ -61,10 +76,10 @@ void ObjectsManager::addCheck(const std::string& objectName, const std::string&
 
 MonitorObject* ObjectsManager::getMonitorObject(std::string objectName)
 {
-  TObject* mo = mMonitorObjects.FindObject(objectName.c_str());
+  auto mo = mMonitorObjectsIndex.find(objectName);
 
-  if (mo) {
-    return dynamic_cast<MonitorObject*>(mo);
+  if (mo != mMonitorObjectsIndex.end()) {
+    return mo->second;
   } else {
     BOOST_THROW_EXCEPTION(ObjectNotFoundError() << errinfo_object_name(objectName));
   }
@@ -82,4 +97,122 @@ void ObjectsManager::addCheck(const TObject* object, const std::string& checkNam
   addCheck(object->GetName(), checkName, checkClassName, checkLibraryName);
 }
 
+TObjArray* ObjectsManager::getNonOwningArrayOfModified()
+{
+  auto* array = new TObjArray();
+  // the map is rebuilt from the published objects, so that it does not keep the ones which are gone
+  std::unordered_map<const MonitorObject*, size_t> checksums;
+  for (const auto& object : mMonitorObjects) {
+    auto* mo = dynamic_cast<MonitorObject*>(object);
+    if (mo == nullptr) {
+      continue;
+    }
+    auto current = checksum(mo->getObject());
+    if (!current) {
+      // no cheap checksum for this type, it is always published
+      array->Add(mo);
+      continue;
+    }
+    auto previous = mPublishedChecksums.find(mo);
+    if (previous == mPublishedChecksums.end() || previous->second != *current) {
+      array->Add(mo);
+    }
+    checksums.emplace(mo, *current);
+  }
+  mPublishedChecksums.swap(checksums);
+  return array;
+}
+
+void ObjectsManager::markAllAsPublished()
+{
+  mPublishedChecksums.clear();
+  for (const auto& object : mMonitorObjects) {
+    auto* mo = dynamic_cast<MonitorObject*>(object);
+    if (mo == nullptr) {
+      continue;
+    }
+    if (auto current = checksum(mo->getObject())) {
+      mPublishedChecksums.emplace(mo, *current);
+    }
+  }
+}
+
+namespace
+{
+
+void combine(size_t& seed, const void* data, size_t size)
+{
+  size_t hash = std::hash<std::string_view>{}(std::string_view(static_cast<const char*>(data), size));
+  seed ^= hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+template <typename T>
+void combine(size_t& seed, const T* array, int size)
+{
+  if (array != nullptr && size > 0) {
+    combine(seed, static_cast<const void*>(array), size * sizeof(T));
+  }
+}
+
+template <typename TArrayType>
+bool combineArray(size_t& seed, const TObject* object)
+{
+  if (auto array = dynamic_cast<const TArrayType*>(object)) {
+    combine(seed, array->GetArray(), array->GetSize());
+    return true;
+  }
+  return false;
+}
+
+/// Combines the TArrayD data member \p member of the object, if its class has one.
+void combineMember(size_t& seed, const TObject* object, const char* member)
+{
+  // the profiles do not expose their bin entries, the member is found through the dictionary instead
+  Long_t offset = object->IsA()->GetDataMemberOffset(member);
+  if (offset > 0) {
+    auto array = reinterpret_cast<const TArrayD*>(reinterpret_cast<const char*>(object) + offset);
+    combine(seed, array->GetArray(), array->GetSize());
+  }
+}
+
+} // namespace
+
+std::optional<size_t> ObjectsManager::checksum(const TObject* object)
+{
+  size_t seed = 0;
+  if (object == nullptr) {
+    return seed;
+  }
+  if (auto histo = dynamic_cast<const TH1*>(object)) {
+    // the bin contents are stored in the TArray the concrete histogram class inherits from
+    if (!combineArray<TArrayD>(seed, histo) && !combineArray<TArrayF>(seed, histo) &&
+        !combineArray<TArrayI>(seed, histo) && !combineArray<TArrayS>(seed, histo)) {
+      combineArray<TArrayC>(seed, histo);
+    }
+    const TArrayD* sumw2 = histo->GetSumw2();
+    combine(seed, sumw2->GetArray(), sumw2->GetSize());
+    double entries = histo->GetEntries();
+    combine(seed, &entries, sizeof(entries));
+    int cells = histo->GetNcells();
+    combine(seed, &cells, sizeof(cells));
+    if (histo->InheritsFrom(TProfile::Class()) || histo->InheritsFrom(TProfile2D::Class()) ||
+        histo->InheritsFrom(TProfile3D::Class())) {
+      // the bin contents of a profile are sums, its means also depend on the bin entries
+      combineMember(seed, histo, "fBinEntries");
+      combineMember(seed, histo, "fBinSumw2");
+    }
+  } else if (auto graph = dynamic_cast<const TGraph*>(object)) {
+    int points = graph->GetN();
+    combine(seed, &points, sizeof(points));
+    combine(seed, graph->GetX(), points);
+    combine(seed, graph->GetY(), points);
+    combine(seed, graph->GetEX(), points);
+    combine(seed, graph->GetEY(), points);
+  } else {
+    // serializing the other types would cost as much as publishing them
+    return std::nullopt;
+  }
+  return seed;
+}
+
 } // namespace o2::quality_control::core
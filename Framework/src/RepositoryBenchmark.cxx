@@ -15,17 +15,24 @@
 
 #include "RepositoryBenchmark.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <future>
+#include <random>
 #include <thread> // this_thread::sleep_for
 
 #include <QualityControl/CcdbDatabase.h>
-#include <TH2F.h>
+#include <TROOT.h>
 
 #include <FairMQLogger.h>
 #include <options/FairMQProgOptions.h> // device->fConfig
 
 #include "Common/Exceptions.h"
 #include "QualityControl/DatabaseFactory.h"
+#include "QualityControl/LatencyHistogram.h"
+#include "QualityControl/ObjectGenerator.h"
 #include "QualityControl/QcInfoLogger.h"
 
 using namespace std;
@@ -37,61 +44,74 @@ using namespace o2::monitoring;
 namespace o2::quality_control::core
 {
 
+namespace
+{
+/// Draws the indices of the objects following a Zipf distribution : the probability of the index i (from 0) is
+/// proportional to 1 / (i + 1)^exponent. An exponent of 0 gives a uniform distribution. There must be at least one key.
+class KeyDistribution
+{
+ public:
+  KeyDistribution(size_t numberKeys, double exponent)
+  {
+    if (numberKeys == 0) {
+      BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("The distribution of the keys needs at least one key"));
+    }
+    double sum = 0;
+    for (size_t rank = 1; rank <= numberKeys; rank++) {
+      sum += 1 / pow(rank, exponent);
+      mCumulated.push_back(sum);
+    }
+  }
+
+  size_t operator()(mt19937_64& generator) const
+  {
+    uniform_real_distribution<double> uniform(0, mCumulated.back());
+    size_t index = upper_bound(mCumulated.begin(), mCumulated.end(), uniform(generator)) - mCumulated.begin();
+    return min(index, mCumulated.size() - 1);
+  }
+
+ private:
+  vector<double> mCumulated;
+};
+} // namespace
+
 RepositoryBenchmark::RepositoryBenchmark()
   : mMaxIterations(0),
     mNumIterations(0),
     mNumberObjects(1),
     mSizeObjects(1),
+    mLoadThreads(0),
+    mTargetRate(0),
+    mLoadDuration(0),
     mThreadedMonitoring(true),
     mTotalNumberObjects(0)
 {
 }
 
-TH1* RepositoryBenchmark::createHisto(uint64_t sizeObjects, string name)
+TObject* RepositoryBenchmark::createObject(string name)
 {
-  TH1* myHisto;
-
-  // Prepare objects (and clean up existing ones)
-  switch (sizeObjects) {
-    case 1:
-      myHisto = new TH1F(name.c_str(), "h", 100, 0, 99); // 1kB
-      break;
-    case 10:
-      myHisto = new TH1F(name.c_str(), "h", 2400, 0, 99); // 10kB
-      break;
-    case 100:
-      myHisto = new TH2F(name.c_str(), "h", 260, 0, 99, 100, 0, 99); // 100kB
-      break;
-    case 500:
-      myHisto = new TH2F(name.c_str(), "h", 1250, 0, 99, 100, 0, 99); // 500kB
-      break;
-    case 1000:
-      myHisto = new TH2F(name.c_str(), "h", 2500, 0, 99, 100, 0, 99); // 1MB
-      break;
-    case 2500:
-      myHisto = new TH2F(name.c_str(), "h", 6250, 0, 99, 100, 0, 99); // 2.5MB
-      break;
-    case 5000:
-      myHisto = new TH2F(name.c_str(), "h", 12500, 0, 99, 100, 0, 99); // 5MB
-      break;
-    default:
-      BOOST_THROW_EXCEPTION(
-        FatalException() << errinfo_details(
-          "size of histo must be 1, 10, 100, 500, 1000, 2500 or 5000 (was: " + to_string(mSizeObjects) + ")"));
-  }
-  return myHisto;
+  // the types used before any type could be chosen
+  auto type = mTypeObjects.empty() ? (mSizeObjects < 100 ? ObjectGenerator::Type::TH1F : ObjectGenerator::Type::TH2F)
+                                   : ObjectGenerator::getType(mTypeObjects);
+  return mObjectGenerator.generate(type, name, mSizeObjects * 1000, ObjectGenerator::getContent(mContentObjects));
 }
 
 void RepositoryBenchmark::InitTask()
 {
   // parse arguments database
-  string dbUrl = fConfig->GetValue<string>("database-url");
-  string dbBackend = fConfig->GetValue<string>("database-backend");
+  mDatabaseBackend = fConfig->GetValue<string>("database-backend");
+  mDatabaseConfig = { { "host", fConfig->GetValue<string>("database-url") },
+                      { "name", fConfig->GetValue<string>("database-name") },
+                      { "username", fConfig->GetValue<string>("database-username") },
+                      { "password", fConfig->GetValue<string>("database-password") },
+                      { "uploadConnections", to_string(fConfig->GetValue<uint64_t>("upload-connections")) } };
+  if (auto batchSize = fConfig->GetValue<uint64_t>("batch-size"); batchSize > 0) {
+    mDatabaseConfig["batchSize"] = to_string(batchSize);
+  }
   mTaskName = fConfig->GetValue<string>("task-name");
   try {
-    mDatabase = o2::quality_control::repository::DatabaseFactory::create(dbBackend);
-    mDatabase->connect(fConfig->GetValue<string>("database-url"), fConfig->GetValue<string>("database-name"),
-                       fConfig->GetValue<string>("database-username"), fConfig->GetValue<string>("database-password"));
+    mDatabase = o2::quality_control::repository::DatabaseFactory::create(mDatabaseBackend);
+    mDatabase->connect(mDatabaseConfig);
     mDatabase->prepareTaskDataContainer(mTaskName);
   } catch (boost::exception& exc) {
     string diagnostic = boost::current_exception_diagnostic_information();
@@ -106,8 +126,31 @@ void RepositoryBenchmark::InitTask()
   mMaxIterations = fConfig->GetValue<uint64_t>("max-iterations");
   mNumberObjects = fConfig->GetValue<uint64_t>("number-objects");
   mSizeObjects = fConfig->GetValue<uint64_t>("size-objects");
+  mTypeObjects = fConfig->GetValue<string>("type-objects");
+  mContentObjects = fConfig->GetValue<string>("content-objects");
   mDeletionMode = static_cast<bool>(fConfig->GetValue<int>("delete"));
+  mStoreAsync = static_cast<bool>(fConfig->GetValue<int>("store-async"));
   mObjectName = fConfig->GetValue<string>("object-name");
+  mLoadThreads = fConfig->GetValue<uint64_t>("load-threads");
+  mTargetRate = fConfig->GetValue<double>("target-rate");
+  mLoadDuration = fConfig->GetValue<uint64_t>("load-duration");
+  mLoadOperation = fConfig->GetValue<string>("load-operation");
+  mKeyDistribution = fConfig->GetValue<string>("key-distribution");
+  mZipfExponent = fConfig->GetValue<double>("zipf-exponent");
+  if (mNumberObjects == 0) {
+    // the load mode draws the objects among them
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("number-objects must be at least 1"));
+  }
+  if (mLoadOperation != "store" && mLoadOperation != "retrieve" && mLoadOperation != "retrieveJson" &&
+      mLoadOperation != "getPublishedObjectNames" && mLoadOperation != "getListOfTasksWithPublications") {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details(
+                            "load-operation must be store, retrieve, retrieveJson, getPublishedObjectNames or "
+                            "getListOfTasksWithPublications (was: " + mLoadOperation + ")"));
+  }
+  if (mKeyDistribution != "uniform" && mKeyDistribution != "zipf") {
+    BOOST_THROW_EXCEPTION(FatalException() << errinfo_details("key-distribution must be uniform or zipf (was: " +
+                                                              mKeyDistribution + ")"));
+  }
   auto numberTasks = fConfig->GetValue<uint64_t>("number-tasks");
 
   // monitoring
@@ -131,8 +174,7 @@ void RepositoryBenchmark::InitTask()
 
   // prepare objects
   for (uint64_t i = 0; i < mNumberObjects; i++) {
-    TH1* histo = createHisto(mSizeObjects, mObjectName + to_string(i));
-    shared_ptr<MonitorObject> mo = make_shared<MonitorObject>(histo, mTaskName);
+    shared_ptr<MonitorObject> mo = make_shared<MonitorObject>(createObject(mObjectName + to_string(i)), mTaskName);
     mo->setIsOwner(true);
     mMyObjects.push_back(mo);
   }
@@ -159,14 +201,32 @@ bool RepositoryBenchmark::ConditionalRun()
   if (mDeletionMode) { // the only way to not run is to return false from here.
     return false;
   }
+  if (mLoadThreads > 0) {
+    runLoad();
+    return false;
+  }
 
   high_resolution_clock::time_point t1 = high_resolution_clock::now();
 
   // Store the object
-  for (unsigned int i = 0; i < mNumberObjects; i++) {
-    mDatabase->store(mMyObjects[i]);
-    mTotalNumberObjects++;
+  if (mStoreAsync) {
+    // all the objects are in flight at the same time, as far as the backend allows
+    vector<future<void>> stored;
+    for (unsigned int i = 0; i < mNumberObjects; i++) {
+      stored.push_back(mDatabase->storeAsync(mMyObjects[i]));
+    }
+    for (auto& s : stored) {
+      s.get();
+      mTotalNumberObjects++;
+    }
+  } else {
+    for (unsigned int i = 0; i < mNumberObjects; i++) {
+      mDatabase->store(mMyObjects[i]);
+      mTotalNumberObjects++;
+    }
   }
+  // the objects written in the background (MySql) are included in the duration
+  mDatabase->flush();
   if (!mThreadedMonitoring) {
     mMonitoring->send({ mTotalNumberObjects, "objectsSent" }, DerivedMetricMode::RATE);
   }
@@ -194,6 +254,146 @@ bool RepositoryBenchmark::ConditionalRun()
   return true;
 }
 
+void RepositoryBenchmark::runLoad()
+{
+  ROOT::EnableThreadSafety(); // the objects are serialized concurrently
+
+  bool storing = mLoadOperation == "store";
+  if (!storing) {
+    // the objects to read must exist
+    for (const auto& mo : mMyObjects) {
+      mDatabase->store(mo);
+    }
+    mDatabase->flush();
+  }
+
+  // Every client has its own connection and its own copy of the objects, as if it was a separate task. A local
+  // database can be opened only once, its clients share the connection of the device.
+  bool sharedConnection = mDatabaseBackend == "Local";
+  vector<unique_ptr<DatabaseInterface>> connections;
+  vector<DatabaseInterface*> databases;
+  vector<vector<shared_ptr<MonitorObject>>> objects(mLoadThreads);
+  for (uint64_t client = 0; client < mLoadThreads; client++) {
+    if (sharedConnection) {
+      databases.push_back(mDatabase.get());
+    } else {
+      connections.push_back(DatabaseFactory::create(mDatabaseBackend));
+      connections.back()->connect(mDatabaseConfig);
+      databases.push_back(connections.back().get());
+    }
+    for (uint64_t i = 0; storing && i < mNumberObjects; i++) {
+      objects[client].push_back(make_shared<MonitorObject>(createObject(mObjectName + to_string(i)), mTaskName));
+      objects[client].back()->setIsOwner(true);
+    }
+  }
+  KeyDistribution keys(mNumberObjects, mKeyDistribution == "zipf" ? mZipfExponent : 0);
+
+  // Calls the operation on the object of the given index. Returns false if the object was not found.
+  auto run = [this](DatabaseInterface& database, const vector<shared_ptr<MonitorObject>>& objects, size_t index) {
+    if (mLoadOperation == "store") {
+      // the backends writing in the background (MySql) would otherwise only be measured queuing the object
+      database.store(objects[index]);
+      database.flush();
+    } else if (mLoadOperation == "retrieve") {
+      unique_ptr<MonitorObject> mo(database.retrieve(mTaskName, mObjectName + to_string(index)));
+      return mo != nullptr;
+    } else if (mLoadOperation == "retrieveJson") {
+      return !database.retrieveJson(mTaskName, mObjectName + to_string(index)).empty();
+    } else if (mLoadOperation == "getPublishedObjectNames") {
+      database.getPublishedObjectNames(mTaskName);
+    } else {
+      database.getListOfTasksWithPublications();
+    }
+    return true;
+  };
+
+  bool openLoop = mTargetRate > 0;
+  QcInfoLogger::GetInstance() << "Calling " << mLoadOperation << " with " << mLoadThreads << " clients during "
+                              << mLoadDuration << " s, "
+                              << (openLoop ? to_string(mTargetRate) + " times per second" : "as fast as possible")
+                              << ", on " << mNumberObjects << " objects (" << mKeyDistribution << ")"
+                              << infologger::endm;
+
+  // Open loop : the operations are scheduled at the target rate whatever the time they take. Each one is picked by
+  // the first free client and its latency is counted from its scheduled time, thus it includes the time spent waiting
+  // for a client when the repository does not keep up.
+  // Closed loop (no target rate) : every client calls the next operation as soon as the previous one is over, which
+  // gives the capacity of the repository for this number of clients.
+  auto numberOperations = static_cast<uint64_t>(mTargetRate * mLoadDuration);
+  duration<double> interval(openLoop ? 1 / mTargetRate : 0);
+  atomic<uint64_t> nextOperation(0);
+  vector<LatencyHistogram> latencies(mLoadThreads); // us
+  vector<uint64_t> failures(mLoadThreads, 0);
+  vector<thread> clients;
+  auto start = steady_clock::now();
+  auto stop = start + seconds(mLoadDuration);
+  for (uint64_t client = 0; client < mLoadThreads; client++) {
+    clients.emplace_back([&, client] {
+      mt19937_64 generator(client);
+      while (true) {
+        steady_clock::time_point scheduled;
+        if (openLoop) {
+          uint64_t operation = nextOperation++;
+          if (operation >= numberOperations) {
+            break;
+          }
+          scheduled = start + duration_cast<steady_clock::duration>(interval * operation);
+          this_thread::sleep_until(scheduled);
+        } else if ((scheduled = steady_clock::now()) >= stop) {
+          break;
+        }
+        try {
+          if (!run(*databases[client], objects[client], keys(generator))) {
+            failures[client]++;
+            continue;
+          }
+        } catch (...) {
+          failures[client]++;
+          continue;
+        }
+        latencies[client].record(duration_cast<microseconds>(steady_clock::now() - scheduled).count());
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  double elapsed = duration<double>(steady_clock::now() - start).count();
+
+  LatencyHistogram latency;
+  uint64_t failed = 0;
+  for (uint64_t client = 0; client < mLoadThreads; client++) {
+    latency.add(latencies[client]);
+    failed += failures[client];
+  }
+  if (storing) {
+    mTotalNumberObjects += latency.getCount();
+  }
+  double throughput = latency.getCount() / elapsed;
+  QcInfoLogger::GetInstance() << "Called " << mLoadOperation << " " << latency.getCount() << " times (" << failed
+                              << " failures) in " << elapsed << " s : " << throughput << " per second"
+                              << infologger::endm;
+  QcInfoLogger::GetInstance() << "Latency (ms) : p50 " << latency.getValueAtPercentile(50) / 1000.
+                              << ", p90 " << latency.getValueAtPercentile(90) / 1000. << ", p99 "
+                              << latency.getValueAtPercentile(99) / 1000. << ", p99.9 "
+                              << latency.getValueAtPercentile(99.9) / 1000. << ", max " << latency.getMax() / 1000.
+                              << ", mean " << latency.getMean() / 1000. << infologger::endm;
+  mMonitoring->sendGrouped("ccdb-benchmark-load-" + mLoadOperation,
+                           { { mTargetRate, "target-rate" },
+                             { throughput, "throughput" },
+                             { latency.getCount(), "succeeded" },
+                             { failed, "failed" },
+                             { latency.getValueAtPercentile(50), "latency-p50_us" },
+                             { latency.getValueAtPercentile(90), "latency-p90_us" },
+                             { latency.getValueAtPercentile(99), "latency-p99_us" },
+                             { latency.getValueAtPercentile(99.9), "latency-p999_us" },
+                             { latency.getMax(), "latency-max_us" } });
+
+  for (auto& connection : connections) {
+    connection->disconnect();
+  }
+}
+
 void RepositoryBenchmark::emptyDatabase()
 {
   mDatabase->truncate(mTaskName, mObjectName);
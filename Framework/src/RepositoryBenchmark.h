@@ -17,10 +17,12 @@
 #define QC_REPOSITORYBENCHMARK_H
 
 #include "QualityControl/CcdbDatabase.h"
+#include "QualityControl/ObjectGenerator.h"
 #include <FairMQDevice.h>
 #include <Monitoring/MonitoringFactory.h>
 #include <TH1F.h>
 #include <boost/asio.hpp>
+#include <unordered_map>
 
 namespace o2::quality_control::core
 {
@@ -36,7 +38,10 @@ class RepositoryBenchmark : public FairMQDevice
   virtual bool ConditionalRun();
   void emptyDatabase();
   void checkTimedOut();
-  TH1* createHisto(uint64_t sizeObjects, std::string name);
+  /// Calls the load operation from mLoadThreads clients at the target rate, or as fast as possible, during
+  /// mLoadDuration, then reports the latencies.
+  void runLoad();
+  TObject* createObject(std::string name);
 
  private:
   // user params
@@ -44,9 +49,18 @@ class RepositoryBenchmark : public FairMQDevice
   uint64_t mNumIterations;
   uint64_t mNumberObjects;
   uint64_t mSizeObjects;
+  std::string mTypeObjects; // empty for TH1F below 100 kB and TH2F above
+  std::string mContentObjects;
   std::string mTaskName;
   std::string mObjectName;
   bool mDeletionMode;
+  bool mStoreAsync;
+  uint64_t mLoadThreads; // 0 when not in load mode
+  double mTargetRate;    // operations per second for all the clients, 0 for as fast as possible
+  uint64_t mLoadDuration;
+  std::string mLoadOperation; // the name of the DatabaseInterface method to call
+  std::string mKeyDistribution;
+  double mZipfExponent;
 
   // monitoring
   std::unique_ptr<o2::monitoring::Monitoring> mMonitoring;
@@ -55,8 +69,11 @@ class RepositoryBenchmark : public FairMQDevice
   uint64_t mThreadedMonitoringInterval;
 
   // internal state
+  std::string mDatabaseBackend;
+  std::unordered_map<std::string, std::string> mDatabaseConfig;
   std::unique_ptr<o2::quality_control::repository::DatabaseInterface> mDatabase;
   std::vector<std::shared_ptr<MonitorObject>> mMyObjects;
+  ObjectGenerator mObjectGenerator;
 //  TH1* mMyHisto;
 
   // variables for the timer
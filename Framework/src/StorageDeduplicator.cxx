@@ -0,0 +1,67 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   StorageDeduplicator.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/StorageDeduplicator.h"
+
+#include <string_view>
+// ROOT
+#include <TBufferFile.h>
+
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::checker
+{
+
+StorageDeduplicator::StorageDeduplicator(std::chrono::steady_clock::duration maxAge) : mMaxAge(maxAge) {}
+
+StorageDeduplicator::Content StorageDeduplicator::hashContent(const MonitorObject& mo)
+{
+  thread_local TBufferFile buffer(TBuffer::kWrite);
+  buffer.Reset();
+  buffer.WriteObject(&mo);
+  return { std::hash<std::string_view>{}(std::string_view(buffer.Buffer(), buffer.Length())),
+           static_cast<size_t>(buffer.Length()) };
+}
+
+bool StorageDeduplicator::needsStorage(const std::string& objectName, const Content& content,
+                                       std::chrono::steady_clock::time_point now)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto stored = mStoredVersions.find(objectName);
+  if (stored != mStoredVersions.end() && stored->second.content == content && now - stored->second.time < mMaxAge) {
+    mDeduplicated++;
+    return false;
+  }
+  mStoredVersions[objectName] = StoredVersion{ content, now };
+  return true;
+}
+
+void StorageDeduplicator::storageFailed(const std::string& objectName, const Content& content)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto stored = mStoredVersions.find(objectName);
+  // a newer version might have been recorded while this one was waiting to be stored
+  if (stored != mStoredVersions.end() && stored->second.content == content) {
+    mStoredVersions.erase(stored);
+  }
+}
+
+unsigned long StorageDeduplicator::getNumberOfDeduplicated()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mDeduplicated;
+}
+
+} // namespace o2::quality_control::checker
@@ -14,6 +14,8 @@
 /// \author Piotr Konopka
 ///
 
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <iostream>
 
@@ -26,10 +28,15 @@
 #include "Framework/DataSampling.h"
 #include "Framework/CallbackService.h"
 #include "Framework/DataSamplingPolicy.h"
+#include "Headers/Stack.h"
 #include "Monitoring/MonitoringFactory.h"
+#include "QualityControl/BackgroundPublisher.h"
+#include "QualityControl/CycleHeader.h"
 #include "QualityControl/QcInfoLogger.h"
 #include "QualityControl/TaskFactory.h"
 #include "QualityControl/TaskRunner.h"
+#include "QualityControl/TaskRunnerFactory.h"
+#include "QualityControl/TaskWorkerPool.h"
 
 namespace o2::quality_control::core
 {
@@ -38,6 +45,24 @@ using namespace o2::configuration;
 using namespace o2::monitoring;
 using namespace std::chrono;
 
+/// \brief Creates a histogram of durations in milliseconds, with logarithmic bins from 1 us to 100 s.
+static TH1F* createDurationHistogram(const std::string& name)
+{
+  const int numberBins = 80;
+  double edges[numberBins + 1];
+  for (int i = 0; i <= numberBins; i++) {
+    edges[i] = std::pow(10., -3. + 8. * i / numberBins);
+  }
+  auto* histo = new TH1F(name.c_str(), (name + ";duration [ms];count").c_str(), numberBins, edges);
+  histo->SetDirectory(nullptr);
+  return histo;
+}
+
+static double millisecondsSince(steady_clock::time_point start)
+{
+  return duration_cast<duration<double, std::milli>>(steady_clock::now() - start).count();
+}
+
 TaskRunner::TaskRunner(const std::string& taskName, const std::string& configurationSource, size_t id)
   : mTaskName(taskName),
     mMonitorObjectsSpec({ "mo" }, createTaskDataOrigin(), createTaskDataDescription(taskName), id),
@@ -47,11 +72,18 @@ TaskRunner::TaskRunner(const std::string& taskName, const std::string& configura
     mLastNumberObjects(0),
     mCycleOn(false),
     mCycleNumber(0),
-    mTotalNumberObjectsPublished(0)
+    mBackgroundCycleNumber(0),
+    mTotalNumberObjectsPublished(0),
+    mMonitorDataDurationInCycle(0)
 {
   // setup configuration
   mConfigFile = ConfigurationFactory::getConfiguration(configurationSource);
   populateConfig(mTaskName);
+
+  // The timer wakes up the task runner even if no data arrive, so that the cycles are closed on time.
+  mInputSpecs.push_back(
+    InputSpec{ timerBinding, createTaskDataOrigin(), createTimerDataDescription(taskName),
+               static_cast<header::DataHeader::SubSpecificationType>(id), Lifetime::Timer });
 }
 
 TaskRunner::~TaskRunner() = default;
@@ -60,6 +92,15 @@ void TaskRunner::initCallback(InitContext& iCtx)
 {
   QcInfoLogger::GetInstance() << "initializing TaskRunner" << AliceO2::InfoLogger::InfoLogger::endm;
 
+  // Without its completion policy, the timer and the data inputs are waited for together.
+  const auto& completionPolicy = iCtx.services().get<RawDeviceService>().spec().completionPolicy;
+  if (completionPolicy.name != TaskRunnerFactory::completionPolicyName) {
+    LOG(WARNING) << "The completion policy of the task " << mTaskName << " is '" << completionPolicy.name
+                 << "' instead of '" << TaskRunnerFactory::completionPolicyName
+                 << "', its cycles might not be closed on time. Call TaskRunnerFactory::customizeInfrastructure in "
+                 << "the customize function of the workflow.";
+  }
+
   // registering state machine callbacks
   iCtx.services().get<framework::CallbackService>().set(framework::CallbackService::Id::Start, [this]() { start(); });
   iCtx.services().get<framework::CallbackService>().set(framework::CallbackService::Id::Stop, [this]() { stop(); });
@@ -72,6 +113,15 @@ void TaskRunner::initCallback(InitContext& iCtx)
 
   // setup publisher
   mObjectsManager = std::make_shared<ObjectsManager>(mTaskConfig);
+  if (mTaskConfig.backgroundPublication) {
+    mBackgroundPublisher = std::make_unique<BackgroundPublisher>();
+  }
+
+  // setup timing histograms
+  mMonitorDataDurations.reset(createDurationHistogram(mTaskName + "_monitorData_duration"));
+  mEndOfCycleDurations.reset(createDurationHistogram(mTaskName + "_endOfCycle_duration"));
+  mSerializationDurations.reset(createDurationHistogram(mTaskName + "_serialization_duration"));
+  mSendDurations.reset(createDurationHistogram(mTaskName + "_send_duration"));
 
   // setup user's task
   TaskFactory f;
@@ -79,26 +129,52 @@ void TaskRunner::initCallback(InitContext& iCtx)
 
   // init user's task
   mTask->initialize(iCtx);
+
+  // In the parallel mode, the instance above only publishes the objects, the data are processed by the workers.
+  if (mTaskConfig.numberOfWorkers > 1) {
+    mWorkers = std::make_unique<TaskWorkerPool>(mTaskConfig.numberOfWorkers, mTaskConfig, mInputSpecs);
+    mWorkers->initialize(iCtx);
+  }
 }
 
 void TaskRunner::processCallback(ProcessingContext& pCtx)
 {
+  if (mBackgroundPublisher) {
+    sendSerializedObjects(pCtx.outputs(), false);
+  }
+
   if (mTaskConfig.maxNumberCycles >= 0 && mCycleNumber >= mTaskConfig.maxNumberCycles) {
     LOG(INFO) << "The maximum number of cycles (" << mTaskConfig.maxNumberCycles << ") has been reached.";
     return;
   }
 
   if (!mCycleOn) {
-    QcInfoLogger::GetInstance() << "cycle " << mCycleNumber << AliceO2::InfoLogger::InfoLogger::endm;
-
-    mTask->startOfCycle();
+    startCycle();
+  }
 
-    mNumberBlocks = 0;
-    mCycleOn = true;
+  // the callback might have been triggered only by the cycle timer
+  if (isDataReady(pCtx.inputs())) {
+    auto start = steady_clock::now();
+    if (mWorkers) {
+      mWorkers->dispatch(pCtx);
+    } else {
+      mTask->monitorData(pCtx);
+    }
+    double duration = millisecondsSince(start);
+    mMonitorDataDurations->Fill(duration);
+    mMonitorDataDurationInCycle += duration;
+    mNumberBlocks++;
   }
 
-  mTask->monitorData(pCtx);
-  mNumberBlocks++;
+  if (mCycleTimer.isTimeout()) {
+    timerCallback(pCtx);
+    if (mResetAfterPublish) {
+      mTask->reset();
+      if (mWorkers) {
+        mWorkers->reset();
+      }
+    }
+  }
 
   // if 10 s we publish stats
   if (mStatsTimer.isTimeout()) {
@@ -107,17 +183,28 @@ void TaskRunner::processCallback(ProcessingContext& pCtx)
     mLastNumberObjects = mTotalNumberObjectsPublished;
     mCollector->send({ objectsPublished / current, "QC_task_Rate_objects_published_per_10_seconds" });
     mStatsTimer.increment();
-
-    // temporarily here, until timer callback is implemented in dpl
-    timerCallback(pCtx);
-    if (mResetAfterPublish) {
-      mTask->reset();
-    }
   }
 }
 
 void TaskRunner::timerCallback(ProcessingContext& pCtx) { finishCycle(pCtx.outputs()); }
 
+Options TaskRunner::getOptions()
+{
+  // The timer only wakes up the task runner, the cycle duration is verified at each invocation. Thus, a period of
+  // 1 s is enough to close the cycles on time, given that their duration is expressed in seconds.
+  return Options{ { std::string("period-") + timerBinding, VariantType::Int, 1000000, { "Period of the cycle timer (us)" } } };
+}
+
+bool TaskRunner::isDataReady(InputRecord& inputs)
+{
+  for (const auto& input : inputs) {
+    if (input.header != nullptr && input.spec != nullptr && input.spec->binding != timerBinding) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void TaskRunner::setResetAfterPublish(bool resetAfterPublish) { mResetAfterPublish = resetAfterPublish; }
 
 header::DataOrigin TaskRunner::createTaskDataOrigin()
@@ -132,6 +219,22 @@ header::DataDescription TaskRunner::createTaskDataDescription(const std::string&
   return description;
 }
 
+header::DataDescription TaskRunner::createTimerDataDescription(const std::string& taskName)
+{
+  o2::header::DataDescription description;
+  description.runtimeInit(std::string(taskName.substr(0, header::DataDescription::size - 4) + "-tmr").c_str());
+  return description;
+}
+
+bool TaskRunner::isTimerHeader(const header::DataHeader& dataHeader)
+{
+  // the description is padded with zeros
+  std::string description(dataHeader.dataDescription.str,
+                          strnlen(dataHeader.dataDescription.str, header::DataDescription::size));
+  return dataHeader.dataOrigin == createTaskDataOrigin() && description.size() >= 4 &&
+         description.compare(description.size() - 4, 4, "-tmr") == 0;
+}
+
 void TaskRunner::start()
 {
   startOfActivity();
@@ -139,24 +242,30 @@ void TaskRunner::start()
   mStatsTimer.reset(10000000); // 10 s.
   mLastNumberObjects = 0;
 
-  QcInfoLogger::GetInstance() << "cycle " << mCycleNumber << AliceO2::InfoLogger::InfoLogger::endm;
-  mNumberBlocks = 0;
-  mCycleOn = true;
+  startCycle();
 }
 
 void TaskRunner::stop()
 {
   if (mCycleOn) {
+    if (mWorkers) {
+      mWorkers->endOfCycle(*mObjectsManager);
+    }
     mTask->endOfCycle();
     mCycleNumber++;
     mCycleOn = false;
   }
   endOfActivity();
   mTask->reset();
+  if (mWorkers) {
+    mWorkers->reset();
+  }
 }
 
 void TaskRunner::reset()
 {
+  mWorkers.reset();
+  mBackgroundPublisher.reset();
   mTask.reset();
   mCollector.reset();
   mObjectsManager.reset();
@@ -176,6 +285,10 @@ void TaskRunner::populateConfig(std::string taskName)
     mTaskConfig.className = taskConfigTree->second.get<std::string>("className");
     mTaskConfig.cycleDurationSeconds = taskConfigTree->second.get<int>("cycleDurationSeconds", 10);
     mTaskConfig.maxNumberCycles = taskConfigTree->second.get<int>("maxNumberCycles", -1);
+    mTaskConfig.deltaPublication = taskConfigTree->second.get<bool>("deltaPublication", false);
+    mTaskConfig.fullPublicationPeriod = taskConfigTree->second.get<int>("fullPublicationPeriod", 10);
+    mTaskConfig.numberOfWorkers = taskConfigTree->second.get<int>("numberOfWorkers", 0);
+    mTaskConfig.backgroundPublication = taskConfigTree->second.get<bool>("backgroundPublication", false);
 
     auto policiesFilePath = mConfigFile->get<std::string>("dataSamplingPolicyFile", "");
     ConfigurationInterface* config = policiesFilePath.empty() ? mConfigFile.get() : ConfigurationFactory::getConfiguration(policiesFilePath).get();
@@ -220,6 +333,12 @@ void TaskRunner::populateConfig(std::string taskName)
   LOG(INFO) << ">> Module name : " << mTaskConfig.moduleName;
   LOG(INFO) << ">> Cycle duration seconds : " << mTaskConfig.cycleDurationSeconds;
   LOG(INFO) << ">> Max number cycles : " << mTaskConfig.maxNumberCycles;
+  LOG(INFO) << ">> Delta publication : " << mTaskConfig.deltaPublication;
+  if (mTaskConfig.deltaPublication) {
+    LOG(INFO) << ">> Full publication period (cycles) : " << mTaskConfig.fullPublicationPeriod;
+  }
+  LOG(INFO) << ">> Number of workers : " << mTaskConfig.numberOfWorkers;
+  LOG(INFO) << ">> Background publication : " << mTaskConfig.backgroundPublication;
 }
 
 void TaskRunner::startOfActivity()
@@ -228,6 +347,9 @@ void TaskRunner::startOfActivity()
   Activity activity(mConfigFile->get<int>("qc.config.Activity.number"),
                     mConfigFile->get<int>("qc.config.Activity.type"));
   mTask->startOfActivity(activity);
+  if (mWorkers) {
+    mWorkers->startOfActivity(activity);
+  }
 }
 
 void TaskRunner::endOfActivity()
@@ -235,31 +357,73 @@ void TaskRunner::endOfActivity()
   Activity activity(mConfigFile->get<int>("qc.config.Activity.number"),
                     mConfigFile->get<int>("qc.config.Activity.type"));
   mTask->endOfActivity(activity);
+  if (mWorkers) {
+    mWorkers->endOfActivity(activity);
+  }
 
   double rate = mTotalNumberObjectsPublished / mTimerTotalDurationActivity.getTime();
   mCollector->send({ rate, "QC_task_Rate_objects_published_per_second_whole_run" });
   mCollector->send({ ba::mean(mPCpus), "QC_task_Mean_pcpu_whole_run" });
   mCollector->send({ ba::mean(mPMems), "QC_task_Mean_pmem_whole_run" });
+  sendDurationStatistics();
+}
+
+void TaskRunner::sendDurationStatistics()
+{
+  double probabilities[] = { 0.5, 0.9, 0.99 };
+  double quantiles[3];
+  for (const auto& histo : { mMonitorDataDurations.get(), mEndOfCycleDurations.get(), mSerializationDurations.get(),
+                             mSendDurations.get() }) {
+    if (histo == nullptr || histo->GetEntries() == 0) {
+      continue;
+    }
+    std::string name = std::string("QC_task_") + histo->GetName();
+    histo->GetQuantiles(3, quantiles, probabilities);
+    mCollector->send({ histo->GetMean(), name + "_mean_ms_whole_run" });
+    mCollector->send({ quantiles[0], name + "_p50_ms_whole_run" });
+    mCollector->send({ quantiles[1], name + "_p90_ms_whole_run" });
+    mCollector->send({ quantiles[2], name + "_p99_ms_whole_run" });
+  }
+}
+
+void TaskRunner::startCycle()
+{
+  QcInfoLogger::GetInstance() << "cycle " << mCycleNumber << AliceO2::InfoLogger::InfoLogger::endm;
+
+  mTask->startOfCycle();
+  if (mWorkers) {
+    mWorkers->startOfCycle();
+  }
+
+  mNumberBlocks = 0;
+  mMonitorDataDurationInCycle = 0;
+  mCycleTimer.reset(mTaskConfig.cycleDurationSeconds * 1000000);
+  mCycleOn = true;
 }
 
 void TaskRunner::finishCycle(DataAllocator& outputs)
 {
-  mTask->endOfCycle();
+  double durationCycle = mCycleTimer.getTime();
 
-  double durationCycle = 0; // (boost::posix_time::seconds(mTaskConfig.cycleDurationSeconds) -
-                            // mCycleTimer->expires_from_now()).total_nanoseconds() / double(1e9);
-  // mCycleTimer->expires_at(mCycleTimer->expires_at() +
-  // boost::posix_time::seconds(mTaskConfig.cycleDurationSeconds));
+  auto start = steady_clock::now();
+  if (mWorkers) {
+    mWorkers->endOfCycle(*mObjectsManager);
+  }
+  mTask->endOfCycle();
+  double durationEndOfCycle = millisecondsSince(start);
+  mEndOfCycleDurations->Fill(durationEndOfCycle);
 
   // publication
+  start = steady_clock::now();
   unsigned long numberObjectsPublished = publish(outputs);
+  double durationPublication = millisecondsSince(start) / 1000.;
 
   // monitoring metrics
-  double durationPublication = 0; // (boost::posix_time::seconds(mTaskConfig.cycleDurationSeconds) -
-                                  // mCycleTimer->expires_from_now()).total_nanoseconds() / double(1e9);
   mCollector->send({ mNumberBlocks, "QC_task_Numberofblocks_in_cycle" });
   mCollector->send({ durationCycle, "QC_task_Module_cycle_duration" });
   mCollector->send({ durationPublication, "QC_task_Publication_duration" });
+  mCollector->send({ mMonitorDataDurationInCycle, "QC_task_MonitorData_duration_in_cycle_ms" });
+  mCollector->send({ durationEndOfCycle, "QC_task_EndOfCycle_duration_ms" });
   mCollector->send({ (int)numberObjectsPublished,
                      "QC_task_Number_objects_published_in_cycle" }); // cast due to Monitoring accepting only int
   double rate = numberObjectsPublished / (durationCycle + durationPublication);
@@ -286,15 +450,55 @@ void TaskRunner::finishCycle(DataAllocator& outputs)
 
 unsigned long TaskRunner::publish(DataAllocator& outputs)
 {
-  outputs.adopt(
-    Output{ mMonitorObjectsSpec.origin,
-            mMonitorObjectsSpec.description,
-            mMonitorObjectsSpec.subSpec,
-            mMonitorObjectsSpec.lifetime },
-    dynamic_cast<TObject*>(mObjectsManager->getNonOwningArray())
-  );
-
-  return 1;
+  // In delta mode, only the objects modified since the last cycle are sent. All of them are sent periodically anyway,
+  // so that the receivers which joined late or lost a message eventually get the complete set.
+  bool fullPublication = !mTaskConfig.deltaPublication || mTaskConfig.fullPublicationPeriod <= 1 ||
+                         mCycleNumber % mTaskConfig.fullPublicationPeriod == 0;
+
+  std::unique_ptr<TObjArray> array;
+  if (fullPublication) {
+    array.reset(mObjectsManager->getNonOwningArray());
+    if (mTaskConfig.deltaPublication) {
+      mObjectsManager->markAllAsPublished();
+    }
+  } else {
+    array.reset(mObjectsManager->getNonOwningArrayOfModified());
+  }
+  unsigned long numberObjects = array->GetEntriesFast();
+
+  if (mBackgroundPublisher) {
+    // The objects are only copied here, they are serialized in the background and sent at one of the next
+    // invocations. The previous ones are sent first if it was not done yet.
+    sendSerializedObjects(outputs, true);
+    mBackgroundPublisher->publish(*array);
+    mBackgroundCycleNumber = mCycleNumber;
+  } else {
+    // The buffer is only copied into the message here, the actual sending is done once the callback returns.
+    auto start = steady_clock::now();
+    mSerializer.serialize(*array);
+    mSerializationDurations->Fill(millisecondsSince(start));
+    start = steady_clock::now();
+    mSerializer.send(outputs, createOutput(mCycleNumber));
+    mSendDurations->Fill(millisecondsSince(start));
+  }
+
+  return numberObjects;
+}
+
+void TaskRunner::sendSerializedObjects(DataAllocator& outputs, bool wait)
+{
+  // only the objects of the last call to publish() can be waiting to be sent
+  bool sent = mBackgroundPublisher->send(outputs, createOutput(mBackgroundCycleNumber), wait);
+  if (sent) {
+    mSerializationDurations->Fill(mBackgroundPublisher->getLastSerializationDuration());
+    mSendDurations->Fill(mBackgroundPublisher->getLastSendDuration());
+  }
+}
+
+Output TaskRunner::createOutput(int cycleNumber)
+{
+  return Output{ mMonitorObjectsSpec.origin, mMonitorObjectsSpec.description, mMonitorObjectsSpec.subSpec,
+                 mMonitorObjectsSpec.lifetime, header::Stack{ CycleHeader{ static_cast<uint64_t>(cycleNumber) } } };
 }
 
 } // namespace o2::quality_control::core
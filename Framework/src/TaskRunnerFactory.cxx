@@ -16,6 +16,10 @@
 #include "QualityControl/TaskRunnerFactory.h"
 #include "QualityControl/TaskRunner.h"
 
+#include <algorithm>
+#include <Framework/DeviceSpec.h>
+#include <Headers/DataHeader.h>
+
 namespace o2::quality_control::core
 {
 
@@ -30,6 +34,7 @@ TaskRunnerFactory::create(std::string taskName, std::string configurationSource,
 {
   auto qcTask = std::make_shared<TaskRunner>(taskName, configurationSource, id);
   qcTask->setResetAfterPublish(resetAfterPublish);
+  auto options = qcTask->getOptions();
 
   DataProcessorSpec newTask{
     taskName,
@@ -44,10 +49,41 @@ TaskRunnerFactory::create(std::string taskName, std::string configurationSource,
           qcTask->processCallback(processingContext);
         };
       }
-    }
+    },
+    options
   };
 
   return std::move(newTask);
 }
 
+void TaskRunnerFactory::customizeInfrastructure(std::vector<framework::CompletionPolicy>& policies)
+{
+  CompletionPolicy taskRunnerCompletionPolicy{
+    completionPolicyName,
+    [](DeviceSpec const& device) {
+      return std::find_if(device.inputs.begin(), device.inputs.end(), [](const InputRoute& route) {
+               return route.matcher.binding == TaskRunner::timerBinding;
+             }) != device.inputs.end();
+    },
+    [](gsl::span<PartRef const> const& inputs) {
+      // The timer comes on its own, thus we consume it right away. Otherwise we wait for all the data inputs, as
+      // the default policy does. The parts do not tell their binding, the timer is recognized by its header and the
+      // data are complete when the only missing part is the one of the timer.
+      int missing = 0;
+      for (const auto& input : inputs) {
+        if (input.header == nullptr) {
+          missing++;
+          continue;
+        }
+        const auto* dataHeader = header::get<header::DataHeader*>(static_cast<const char*>(input.header->GetData()));
+        if (dataHeader != nullptr && TaskRunner::isTimerHeader(*dataHeader)) {
+          return CompletionPolicy::CompletionOp::Consume;
+        }
+      }
+      return missing <= 1 ? CompletionPolicy::CompletionOp::Consume : CompletionPolicy::CompletionOp::Wait;
+    }
+  };
+  policies.push_back(taskRunnerCompletionPolicy);
+}
+
 } // namespace o2::quality_control::core
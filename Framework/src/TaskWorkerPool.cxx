@@ -0,0 +1,320 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TaskWorkerPool.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/TaskWorkerPool.h"
+
+#include <algorithm>
+#include <unordered_map>
+// ROOT
+#include <TH1.h>
+#include <TList.h>
+#include <TROOT.h>
+// O2
+#include <FairLogger.h>
+#include "Common/Exceptions.h"
+#include "Framework/DataProcessingHeader.h"
+#include "Framework/InputRecord.h"
+#include "Framework/InputSpan.h"
+#include "Headers/DataHeader.h"
+#include "Headers/Stack.h"
+// QC
+#include "QualityControl/QcInfoLogger.h"
+#include "QualityControl/TaskFactory.h"
+#include "QualityControl/TaskRunner.h"
+
+namespace o2::quality_control::core
+{
+
+using namespace o2::framework;
+using namespace AliceO2::Common;
+
+/// \brief Copy of the data inputs of one invocation of the processing callback.
+/// The n-th header and payload correspond to the n-th route of the pool, they are null if the input is missing.
+struct TaskWorkerPool::Job {
+  std::vector<std::unique_ptr<o2::header::Stack>> headers;
+  std::vector<std::vector<char>> payloads;
+  ServiceRegistry* services;
+  DataAllocator* allocator;
+};
+
+TaskWorkerPool::TaskWorkerPool(size_t numberOfWorkers, TaskConfig& taskConfig, const Inputs& inputSpecs,
+                               TaskCreator createTask)
+  : mTaskConfig(taskConfig),
+    mCreateTask(std::move(createTask)),
+    mMaxQueueSize(4 * numberOfWorkers),
+    mBusyWorkers(0),
+    mStopping(false)
+{
+  if (!mCreateTask) {
+    mCreateTask = [](TaskConfig& config, std::shared_ptr<ObjectsManager> objectsManager) {
+      TaskFactory factory;
+      return factory.create<TaskInterface>(config, objectsManager);
+    };
+  }
+
+  // the objects of the shards are created and filled concurrently
+  ROOT::EnableThreadSafety();
+
+  for (const auto& spec : inputSpecs) {
+    if (spec.binding == TaskRunner::timerBinding) {
+      continue;
+    }
+    mRoutes.push_back(InputRoute{ spec, mRoutes.size(), "", 0 });
+  }
+  mShards.resize(numberOfWorkers);
+}
+
+TaskWorkerPool::~TaskWorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mJobAvailable.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+void TaskWorkerPool::initialize(InitContext& iCtx)
+{
+  for (auto& shard : mShards) {
+    shard = std::make_unique<Shard>();
+    shard->objectsManager = std::make_shared<ObjectsManager>(mTaskConfig);
+    shard->task.reset(mCreateTask(mTaskConfig, shard->objectsManager));
+    shard->task->initialize(iCtx);
+  }
+  for (auto& shard : mShards) {
+    mThreads.emplace_back(&TaskWorkerPool::run, this, std::ref(*shard));
+  }
+  QcInfoLogger::GetInstance() << "monitorData will run on " << mShards.size() << " worker threads"
+                              << AliceO2::InfoLogger::InfoLogger::endm;
+}
+
+void TaskWorkerPool::dispatch(ProcessingContext& pCtx)
+{
+  rethrowWorkerError();
+
+  auto job = std::make_unique<Job>();
+  job->headers.resize(mRoutes.size());
+  job->payloads.resize(mRoutes.size());
+  job->services = &pCtx.services();
+  job->allocator = &pCtx.outputs();
+
+  for (const auto& input : pCtx.inputs()) {
+    if (input.header == nullptr || input.spec == nullptr || input.spec->binding == TaskRunner::timerBinding) {
+      continue;
+    }
+    auto route = std::find_if(mRoutes.begin(), mRoutes.end(), [&input](const InputRoute& r) {
+      return r.matcher.binding == input.spec->binding;
+    });
+    if (route == mRoutes.end()) {
+      continue;
+    }
+    const auto* dataHeader = o2::header::get<header::DataHeader*>(input.header);
+    const auto* processingHeader = o2::header::get<DataProcessingHeader*>(input.header);
+    if (dataHeader == nullptr) {
+      continue;
+    }
+    size_t index = route - mRoutes.begin();
+    job->headers[index] = processingHeader != nullptr
+                            ? std::make_unique<o2::header::Stack>(*dataHeader, *processingHeader)
+                            : std::make_unique<o2::header::Stack>(*dataHeader);
+    job->payloads[index].assign(input.payload, input.payload + dataHeader->payloadSize);
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mJobDone.wait(lock, [this] { return mQueue.size() < mMaxQueueSize; });
+  mQueue.push_back(std::move(job));
+  lock.unlock();
+  mJobAvailable.notify_one();
+}
+
+void TaskWorkerPool::run(Shard& shard)
+{
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mJobAvailable.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+      if (mQueue.empty()) { // stopping
+        return;
+      }
+      job = std::move(mQueue.front());
+      mQueue.pop_front();
+      mBusyWorkers++;
+    }
+    mJobDone.notify_all(); // room in the queue
+
+    // The span gives the header and the payload of the n-th input at positions 2n and 2n+1.
+    InputSpan span{ [&job](size_t i) -> const char* {
+                     if (i % 2 == 0) {
+                       return job->headers[i / 2] ? reinterpret_cast<const char*>(job->headers[i / 2]->data()) : nullptr;
+                     }
+                     return job->headers[i / 2] ? job->payloads[i / 2].data() : nullptr;
+                   },
+                    mRoutes.size() };
+    InputRecord inputs{ mRoutes, std::move(span) };
+    ProcessingContext pCtx{ inputs, *job->services, *job->allocator };
+    try {
+      shard.task->monitorData(pCtx);
+    } catch (...) {
+      std::string diagnostic = boost::current_exception_diagnostic_information();
+      LOG(ERROR) << "Unexpected exception in monitorData of a worker, diagnostic information follows:\n"
+                 << diagnostic;
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mWorkerError) {
+        mWorkerError = std::current_exception();
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mBusyWorkers--;
+    }
+    mJobDone.notify_all();
+  }
+}
+
+void TaskWorkerPool::waitUntilIdle()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mJobDone.wait(lock, [this] { return mQueue.empty() && mBusyWorkers == 0; });
+}
+
+void TaskWorkerPool::rethrowWorkerError()
+{
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::swap(error, mWorkerError);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskWorkerPool::startOfActivity(Activity& activity)
+{
+  waitUntilIdle();
+  for (auto& shard : mShards) {
+    shard->task->startOfActivity(activity);
+  }
+}
+
+void TaskWorkerPool::startOfCycle()
+{
+  waitUntilIdle();
+  for (auto& shard : mShards) {
+    shard->task->startOfCycle();
+  }
+}
+
+void TaskWorkerPool::endOfCycle(ObjectsManager& objectsManager)
+{
+  waitUntilIdle();
+  for (auto& shard : mShards) {
+    shard->task->endOfCycle();
+  }
+  merge(objectsManager);
+  rethrowWorkerError();
+}
+
+void TaskWorkerPool::endOfActivity(Activity& activity)
+{
+  waitUntilIdle();
+  for (auto& shard : mShards) {
+    shard->task->endOfActivity(activity);
+  }
+}
+
+void TaskWorkerPool::reset()
+{
+  waitUntilIdle();
+  for (auto& shard : mShards) {
+    shard->task->reset();
+  }
+}
+
+void TaskWorkerPool::merge(ObjectsManager& objectsManager)
+{
+  // the versions of each object in all the shards are merged at once
+  std::unordered_map<std::string, std::vector<TObject*>> shardObjects;
+  for (auto& shard : mShards) {
+    std::unique_ptr<TObjArray> array(shard->objectsManager->getNonOwningArray());
+    for (const auto& object : *array) {
+      auto* mo = dynamic_cast<MonitorObject*>(object);
+      if (mo != nullptr && mo->getObject() != nullptr) {
+        shardObjects[mo->getName()].push_back(mo->getObject());
+      }
+    }
+  }
+
+  for (const auto& [name, objects] : shardObjects) {
+    MonitorObject* target = nullptr;
+    try {
+      target = objectsManager.getMonitorObject(name);
+    } catch (const ObjectNotFoundError&) {
+      // published by the shards but not by the main instance of the task
+      target = publishCopy(objectsManager, name, objects.front());
+    }
+    if (target == nullptr) {
+      if (mNotMergeable.insert(name).second) {
+        LOG(WARNING) << "Object " << name << " is published only by the workers and cannot be reset, it is lost";
+      }
+      continue;
+    }
+    // the shards are reset after the merge, otherwise their content would be merged again in the next cycle
+    TList updates;
+    for (auto* object : objects) {
+      if (ObjectMerger::isResettable(object)) {
+        updates.Add(object);
+      }
+    }
+    if (updates.GetEntries() != static_cast<Int_t>(objects.size()) ||
+        !mObjectMerger.merge(name, target->getObject(), updates)) {
+      if (mNotMergeable.insert(name).second) {
+        LOG(WARNING) << "Object " << name << " cannot be merged and reset, its content filled by the workers is lost";
+      }
+      continue;
+    }
+    for (auto* object : objects) {
+      ObjectMerger::reset(object);
+    }
+  }
+
+  if (!mObjectMerger.getStatistics().empty()) {
+    LOG(DEBUG) << "Merge times of the workers - " << mObjectMerger.getStatisticsSummary();
+    mObjectMerger.resetStatistics();
+  }
+}
+
+MonitorObject* TaskWorkerPool::publishCopy(ObjectsManager& objectsManager, const std::string& name,
+                                           const TObject* object)
+{
+  if (!ObjectMerger::isResettable(object)) {
+    return nullptr;
+  }
+  std::unique_ptr<TObject> copy(object->Clone());
+  if (auto* histo = dynamic_cast<TH1*>(copy.get())) {
+    histo->SetDirectory(nullptr);
+  }
+  ObjectMerger::reset(copy.get());
+  objectsManager.startPublishing(copy.get(), name);
+  mCopies.push_back(std::move(copy));
+  return objectsManager.getMonitorObject(name);
+}
+
+} // namespace o2::quality_control::core
@@ -0,0 +1,95 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ThreadPool.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace o2::quality_control::core
+{
+
+ThreadPool::ThreadPool(size_t numberOfThreads) : mStopping(false)
+{
+  numberOfThreads = std::max<size_t>(numberOfThreads, 1);
+  for (size_t i = 0; i < numberOfThreads; i++) {
+    mThreads.emplace_back(&ThreadPool::run, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mJobAvailable.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> job)
+{
+  std::packaged_task<void()> task(std::move(job));
+  auto future = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mJobs.push_back(std::move(task));
+  }
+  mJobAvailable.notify_one();
+  return future;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+  std::atomic<size_t> next{ 0 };
+  auto worker = [&next, count, &function]() {
+    for (size_t i = next++; i < count; i = next++) {
+      function(i);
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  for (size_t t = 0; t < std::min(count, mThreads.size()); t++) {
+    futures.push_back(submit(worker));
+  }
+  // all the futures are waited for before rethrowing, because the jobs refer to local variables
+  for (auto& future : futures) {
+    future.wait();
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+void ThreadPool::run()
+{
+  while (true) {
+    std::packaged_task<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mJobAvailable.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+      if (mJobs.empty()) { // stopping
+        return;
+      }
+      job = std::move(mJobs.front());
+      mJobs.pop_front();
+    }
+    job(); // the exceptions are stored in the future
+  }
+}
+
+} // namespace o2::quality_control::core
@@ -33,6 +33,7 @@
 
 #include <Framework/CompletionPolicyHelpers.h>
 #include <Framework/DataSampling.h>
+#include "QualityControl/TaskRunnerFactory.h"
 #include <Framework/DataSpecUtils.h>
 
 using namespace o2::framework;
@@ -43,6 +44,7 @@ using namespace o2::framework;
 void customize(std::vector<CompletionPolicy>& policies)
 {
   DataSampling::CustomizeInfrastructure(policies);
+  o2::quality_control::core::TaskRunnerFactory::customizeInfrastructure(policies);
 
   CompletionPolicy mergerConsumesASAP{
     "mergers-always-consume",
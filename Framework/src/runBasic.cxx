@@ -34,11 +34,13 @@
 /// of glfw being installed or not, in the terminal all the logs will be shown as well.
 
 #include "Framework/DataSampling.h"
+#include "QualityControl/TaskRunnerFactory.h"
 using namespace o2::framework;
 
 void customize(std::vector<CompletionPolicy>& policies)
 {
   DataSampling::CustomizeInfrastructure(policies);
+  o2::quality_control::core::TaskRunnerFactory::customizeInfrastructure(policies);
 }
 
 void customize(std::vector<ChannelConfigurationPolicy>& policies)
@@ -24,7 +24,10 @@ void addCustomOptions(bpo::options_description& options)
   options.add_options()(
     "fake-data-file", bpo::value<std::string>()->default_value(""),
     "File containing JSON to use as input (useful for tests if no tasks is running). It is used to reply to requests. "
-    "It is reloaded every 10 seconds and if it changed it is published to the clients.");
+    "It is reloaded every 10 seconds and if it changed it is published to the clients.")(
+    "updates-format", bpo::value<std::string>()->default_value("full"),
+    "Content of the updates published : \"full\" list of objects of the task (default) or \"delta\" with the objects "
+    "added and removed and a sequence number.");
 }
 
 FairMQDevicePtr getDevice(const FairMQProgOptions& /*config*/)
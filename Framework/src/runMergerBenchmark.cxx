@@ -0,0 +1,104 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file    runMergerBenchmark.cxx
+/// \author Piotr Konopka
+///
+/// \brief Compares the time needed to add histograms with TH1::Add and with ObjectMerger::addBins.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include <boost/program_options.hpp>
+#include <TH2F.h>
+
+#include "QualityControl/ObjectMerger.h"
+
+namespace bpo = boost::program_options;
+using namespace o2::quality_control::core;
+
+namespace
+{
+
+std::unique_ptr<TH2F> createHistogram(int bins, bool weighted, unsigned int seed)
+{
+  auto histo = std::make_unique<TH2F>("benchmark", "benchmark", bins, 0, bins, bins, 0, bins);
+  histo->SetDirectory(nullptr);
+  if (weighted) {
+    histo->Sumw2();
+  }
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(0, bins);
+  for (int i = 0; i < bins * bins; i++) {
+    histo->Fill(distribution(generator), distribution(generator));
+  }
+  return histo;
+}
+
+template <typename Function>
+double measure(size_t iterations, Function&& function)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    function();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  bpo::options_description options("Allowed options");
+  options.add_options()("help,h", "Produce help message")(
+    "bins", bpo::value<int>()->default_value(510),
+    "Number of bins per axis of the TH2F, 510 gives 1 MB of bin contents (default : 510)")(
+    "iterations", bpo::value<size_t>()->default_value(200), "Number of additions measured (default : 200)")(
+    "weighted", bpo::value<bool>()->default_value(false), "Whether the histograms store the squared weights");
+  bpo::variables_map vm;
+  bpo::store(bpo::parse_command_line(argc, argv, options), vm);
+  bpo::notify(vm);
+  if (vm.count("help")) {
+    std::cout << options << std::endl;
+    return 0;
+  }
+  int bins = vm["bins"].as<int>();
+  size_t iterations = vm["iterations"].as<size_t>();
+  bool weighted = vm["weighted"].as<bool>();
+
+  auto update = createHistogram(bins, weighted, 1);
+  auto targetAdd = createHistogram(bins, weighted, 2);
+  auto targetAddBins = createHistogram(bins, weighted, 2);
+
+  double addTime = measure(iterations, [&]() { targetAdd->Add(update.get()); });
+  double addBinsTime = measure(iterations, [&]() { ObjectMerger::addBins(targetAddBins.get(), update.get()); });
+
+  std::cout << "TH2F with " << targetAdd->GetNcells() << " cells (" << targetAdd->GetNcells() * sizeof(Float_t) / 1024
+            << " kB), " << (weighted ? "weighted" : "unweighted") << ", " << iterations << " additions" << std::endl;
+  std::cout << "TH1::Add                : " << addTime << " ms per addition" << std::endl;
+  std::cout << "ObjectMerger::addBins   : " << addBinsTime << " ms per addition" << std::endl;
+  std::cout << "speedup                 : " << addTime / addBinsTime << std::endl;
+
+  // both methods should give the same result
+  bool same = targetAdd->GetEntries() == targetAddBins->GetEntries();
+  for (int i = 0; same && i < targetAdd->GetNcells(); i++) {
+    same = targetAdd->GetBinContent(i) == targetAddBins->GetBinContent(i) &&
+           targetAdd->GetBinError(i) == targetAddBins->GetBinError(i);
+  }
+  if (!same) {
+    std::cerr << "The results of TH1::Add and ObjectMerger::addBins differ" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -23,7 +23,11 @@ void addCustomOptions(bpo::options_description& options)
   options.add_options()("number-objects", bpo::value<uint64_t>()->default_value(1),
                         "Number of objects to try to send to the CCDB every second (default : 1)")(
     "size-objects", bpo::value<uint64_t>()->default_value(1),
-    "Size of the objects to send (in kB, 1, 10, 100, 1000, default : 1)")(
+    "Size of the objects to send, serialized without compression (in kB, default : 1)")(
+    "type-objects", bpo::value<std::string>()->default_value(""),
+    "Type of the objects : TH1F, TH2F, TH3F, TProfile, TGraph or TTree (default : TH1F below 100 kB, TH2F above)")(
+    "content-objects", bpo::value<std::string>()->default_value("empty"),
+    "Content of the objects, from the most to the least compressible : empty (default), sparse, smooth or random")(
     "max-iterations", bpo::value<uint64_t>()->default_value(3),
     "Maximum number of iterations of Run/ConditionalRun/OnData (0 - infinite, default : 3)")(
     "number-tasks", bpo::value<uint64_t>()->default_value(0),
@@ -39,7 +43,27 @@ void addCustomOptions(bpo::options_description& options)
     "delete", bpo::value<int>()->default_value(0),
     "Deletion mode (deletes all the versions of the object, 1:true, 0:false)")(
     "database-backend", bpo::value<std::string>()->default_value("CCDB"),
-    "Name of the database backend (\"CCDB\" (default) or \"MySql\"")(
+    "Name of the database backend (\"CCDB\" (default), \"MySql\" or \"Local\")")(
+    "store-async", bpo::value<int>()->default_value(0),
+    "Whether the objects of an iteration are all stored concurrently (1) or one after the other (0, default)")(
+    "upload-connections", bpo::value<uint64_t>()->default_value(4),
+    "Number of concurrent uploads to the CCDB in asynchronous mode (default : 4)")(
+    "batch-size", bpo::value<uint64_t>()->default_value(0),
+    "Number of objects written at once by the MySql backend (default : 0, the default of the backend)")(
+    "load-threads", bpo::value<uint64_t>()->default_value(0),
+    "Load mode if not 0 : number of clients calling the load operation at the target rate, each on its own thread "
+    "and connection, after which the latency percentiles are reported (default : 0)")(
+    "target-rate", bpo::value<double>()->default_value(100),
+    "Number of operations per second for all the clients in load mode, 0 for as fast as possible (default : 100)")(
+    "load-duration", bpo::value<uint64_t>()->default_value(60),
+    "Duration of the load mode in seconds (default : 60)")(
+    "load-operation", bpo::value<std::string>()->default_value("store"),
+    "Operation of the load mode : \"store\" (default), \"retrieve\", \"retrieveJson\", \"getPublishedObjectNames\" "
+    "or \"getListOfTasksWithPublications\"")(
+    "key-distribution", bpo::value<std::string>()->default_value("uniform"),
+    "Distribution of the objects used in load mode, among number-objects : \"uniform\" (default) or \"zipf\"")(
+    "zipf-exponent", bpo::value<double>()->default_value(1),
+    "Exponent of the zipf distribution, the higher the fewer objects are used (default : 1)")(
     "monitoring-threaded", bpo::value<int>()->default_value(1),
     "Whether to send the objects rate from a dedicated thread (1, default) or directly from the main thread (0)")(
     "monitoring-threaded-interval", bpo::value<int>()->default_value(1),
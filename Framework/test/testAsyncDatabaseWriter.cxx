@@ -0,0 +1,222 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testAsyncDatabaseWriter.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/AsyncDatabaseWriter.h"
+
+#define BOOST_TEST_MODULE AsyncDatabaseWriter test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <Common/Exceptions.h>
+#include <TNamed.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Lets the test decide when the stores of the GatedDatabases are over.
+/// The stores started and done are recorded as "name:version", the version being the title of the object.
+struct Gate {
+  /// Waits until n stores have started, false if it does not happen within a few seconds.
+  bool waitStarted(size_t n)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(10), [&] { return started.size() >= n; });
+  }
+  /// Lets all the current and future stores finish.
+  void open()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isOpen = true;
+    changed.notify_all();
+  }
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<std::string> started;
+  std::vector<std::string> stored;
+  bool isOpen = false;
+};
+
+/// Records the stored objects, each store is blocked until the gate is open. The objects whose version is "fail" are
+/// not stored, the store throws. The ones whose version is "crash" are not stored either, it throws something else
+/// than an exception.
+class GatedDatabase : public DatabaseInterface
+{
+ public:
+  GatedDatabase(Gate& gate) : mGate(gate) {}
+
+  void connect(std::string, std::string, std::string, std::string) override {}
+  void connect(const std::unordered_map<std::string, std::string>&) override {}
+  void store(std::shared_ptr<MonitorObject> mo) override
+  {
+    std::string id = mo->getName() + ":" + mo->getObject()->GetTitle();
+    std::unique_lock<std::mutex> lock(mGate.mutex);
+    mGate.started.push_back(id);
+    mGate.changed.notify_all();
+    mGate.changed.wait(lock, [this] { return mGate.isOpen; });
+    if (std::string(mo->getObject()->GetTitle()) == "fail") {
+      BOOST_THROW_EXCEPTION(AliceO2::Common::DatabaseException() << AliceO2::Common::errinfo_details(id));
+    }
+    if (std::string(mo->getObject()->GetTitle()) == "crash") {
+      throw id;
+    }
+    mGate.stored.push_back(id);
+  }
+  MonitorObject* retrieve(std::string, std::string) override { return nullptr; }
+  std::string retrieveJson(std::string, std::string) override { return ""; }
+  void disconnect() override {}
+  void prepareTaskDataContainer(std::string) override {}
+  std::vector<std::string> getListOfTasksWithPublications() override { return {}; }
+  std::vector<std::string> getPublishedObjectNames(std::string) override { return {}; }
+  void truncate(std::string, std::string) override {}
+
+ private:
+  Gate& mGate;
+};
+
+std::shared_ptr<MonitorObject> makeObject(const std::string& name, const std::string& version)
+{
+  // the version is put in the title to be able to tell the objects apart once stored
+  return std::make_shared<MonitorObject>(new TNamed(name.c_str(), version.c_str()), "task");
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_coalescing)
+{
+  Gate gate;
+  AsyncDatabaseWriter writer([&]() { return std::make_unique<GatedDatabase>(gate); }, 1, 10);
+
+  writer.store(makeObject("a", "1"));
+  BOOST_REQUIRE(gate.waitStarted(1)); // a:1 is being stored
+  writer.store(makeObject("b", "1"));
+  writer.store(makeObject("a", "2")); // queued, a:1 is not pending anymore
+  writer.store(makeObject("b", "2")); // replaces b:1, which keeps its place
+  writer.store(makeObject("a", "3")); // replaces a:2
+  BOOST_CHECK_EQUAL(writer.getStatistics().queueSize, 2);
+  gate.open();
+  writer.flush();
+
+  std::vector<std::string> expected{ "a:1", "b:2", "a:3" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(gate.stored.begin(), gate.stored.end(), expected.begin(), expected.end());
+  auto statistics = writer.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.stored, 3);
+  BOOST_CHECK_EQUAL(statistics.coalesced, 2);
+  BOOST_CHECK_EQUAL(statistics.dropped, 0);
+  BOOST_CHECK_EQUAL(statistics.queueSize, 0);
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_drop)
+{
+  Gate gate;
+  AsyncDatabaseWriter writer([&]() { return std::make_unique<GatedDatabase>(gate); }, 1, 2,
+                             AsyncDatabaseWriter::QueueFullPolicy::Drop);
+
+  writer.store(makeObject("a", "1"));
+  BOOST_REQUIRE(gate.waitStarted(1)); // a:1 is being stored, the queue is empty
+  writer.store(makeObject("b", "1"));
+  writer.store(makeObject("c", "1"));
+  writer.store(makeObject("d", "1")); // the queue is full
+  writer.store(makeObject("b", "2")); // coalescing does not need room in the queue
+  gate.open();
+  writer.flush();
+
+  std::vector<std::string> expected{ "a:1", "b:2", "c:1" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(gate.stored.begin(), gate.stored.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(writer.getStatistics().dropped, 1);
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_parallel)
+{
+  Gate gate;
+  {
+    AsyncDatabaseWriter writer([&]() { return std::make_unique<GatedDatabase>(gate); }, 4, 100);
+    writer.store(makeObject("a", "1"));
+    writer.store(makeObject("a", "2"));
+    for (int i = 0; i < 7; i++) {
+      writer.store(makeObject("object" + std::to_string(i), "1"));
+    }
+    // one store per writer, the second version of a waits for the first one to be stored
+    BOOST_REQUIRE(gate.waitStarted(4));
+    {
+      std::lock_guard<std::mutex> lock(gate.mutex);
+      BOOST_CHECK_EQUAL(gate.started.size(), 4);
+      BOOST_CHECK(std::find(gate.started.begin(), gate.started.end(), "a:2") == gate.started.end());
+    }
+    BOOST_CHECK_EQUAL(writer.getStatistics().queueSize, 5);
+    gate.open();
+  } // the destructor stores what is left
+
+  BOOST_CHECK_EQUAL(gate.stored.size(), 9);
+  auto first = std::find(gate.stored.begin(), gate.stored.end(), "a:1");
+  auto second = std::find(gate.stored.begin(), gate.stored.end(), "a:2");
+  BOOST_CHECK(first < second);
+  BOOST_CHECK_THROW(AsyncDatabaseWriter::policyFromString("wait"), AliceO2::Common::FatalException);
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_completion)
+{
+  Gate gate;
+  AsyncDatabaseWriter writer([&]() { return std::make_unique<GatedDatabase>(gate); }, 1, 1,
+                             AsyncDatabaseWriter::QueueFullPolicy::Drop);
+  std::mutex mutex;
+  std::vector<std::string> results;
+  auto onStored = [&](const std::string& name) {
+    return [&, name](bool stored) {
+      std::lock_guard<std::mutex> lock(mutex);
+      results.push_back(name + (stored ? ":stored" : ":failed"));
+    };
+  };
+
+  writer.store(makeObject("a", "1"), onStored("a"));
+  BOOST_REQUIRE(gate.waitStarted(1));
+  writer.store(makeObject("b", "1"), onStored("b1"));
+  writer.store(makeObject("b", "fail"), onStored("b2")); // replaces b:1, whose callback is not called
+  writer.store(makeObject("c", "1"), onStored("c"));     // dropped, the queue is full
+  gate.open();
+  writer.flush();
+
+  std::vector<std::string> expected{ "c:failed", "a:stored", "b2:failed" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(results.begin(), results.end(), expected.begin(), expected.end());
+  auto statistics = writer.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.stored, 1);
+  BOOST_CHECK_EQUAL(statistics.failed, 1);
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_unknown_exception)
+{
+  Gate gate;
+  gate.open();
+  AsyncDatabaseWriter writer([&]() { return std::make_unique<GatedDatabase>(gate); }, 1, 10);
+  bool result = true;
+  writer.store(makeObject("a", "crash"), [&](bool stored) { result = stored; });
+  writer.flush(); // the writer and the key were released
+  BOOST_CHECK(!result);
+
+  writer.store(makeObject("a", "1"), [&](bool stored) { result = stored; });
+  writer.flush();
+  BOOST_CHECK(result);
+  std::vector<std::string> expected{ "a:1" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(gate.stored.begin(), gate.stored.end(), expected.begin(), expected.end());
+  auto statistics = writer.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.stored, 1);
+  BOOST_CHECK_EQUAL(statistics.failed, 1);
+}
+
+} // namespace o2::quality_control::repository
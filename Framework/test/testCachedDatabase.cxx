@@ -0,0 +1,237 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testCachedDatabase.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/CachedDatabase.h"
+
+#define BOOST_TEST_MODULE CachedDatabase test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <TH1F.h>
+#include <chrono>
+#include <future>
+#include <map>
+#include <thread>
+#include "QualityControl/MonitorObject.h"
+
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+/// Keeps the objects in a map and counts the reads. The objects are returned without the ownership of the object
+/// they wrap, as the tasks stream them.
+class MemoryDatabase : public DatabaseInterface
+{
+ public:
+  explicit MemoryDatabase(int& reads) : mReads(reads) {}
+
+  void connect(std::string, std::string, std::string, std::string) override {}
+  void connect(const std::unordered_map<std::string, std::string>&) override {}
+  void store(std::shared_ptr<MonitorObject> mo) override
+  {
+    mObjects[mo->getTaskName() + "/" + mo->getName()].reset(dynamic_cast<MonitorObject*>(mo->Clone()));
+  }
+  MonitorObject* retrieve(std::string taskName, std::string objectName) override
+  {
+    mReads++;
+    auto mo = mObjects.find(taskName + "/" + objectName);
+    if (mo == mObjects.end()) {
+      return nullptr;
+    }
+    auto* clone = dynamic_cast<MonitorObject*>(mo->second->Clone());
+    clone->setIsOwner(false);
+    return clone;
+  }
+  std::string retrieveJson(std::string, std::string) override { return ""; }
+  void disconnect() override {}
+  void prepareTaskDataContainer(std::string) override {}
+  std::vector<std::string> getListOfTasksWithPublications() override { return {}; }
+  std::vector<std::string> getPublishedObjectNames(std::string) override { return {}; }
+  void truncate(std::string taskName, std::string objectName) override { mObjects.erase(taskName + "/" + objectName); }
+
+ private:
+  int& mReads;
+  std::map<std::string, std::unique_ptr<MonitorObject>> mObjects;
+};
+
+/// Stores the objects given to storeAsync once the test completes the storage.
+class SlowDatabase : public MemoryDatabase
+{
+ public:
+  using MemoryDatabase::MemoryDatabase;
+
+  std::future<void> storeAsync(std::shared_ptr<MonitorObject> mo) override
+  {
+    mStoring = std::move(mo);
+    mStored = std::promise<void>();
+    return mStored.get_future();
+  }
+  void complete()
+  {
+    store(mStoring);
+    mStored.set_value();
+  }
+
+ private:
+  std::shared_ptr<MonitorObject> mStoring;
+  std::promise<void> mStored;
+};
+
+std::shared_ptr<MonitorObject> makeObject(const std::string& name, int entries, int bins = 10)
+{
+  auto* histo = new TH1F(name.c_str(), name.c_str(), bins, 0, bins);
+  histo->SetDirectory(nullptr);
+  for (int i = 0; i < entries; i++) {
+    histo->Fill(i % bins);
+  }
+  return std::make_shared<MonitorObject>(histo, "task");
+}
+
+double entries(MonitorObject* mo) { return dynamic_cast<TH1F*>(mo->getObject())->GetEntries(); }
+
+BOOST_AUTO_TEST_CASE(cache_hits_and_invalidation)
+{
+  int reads = 0;
+  CachedDatabase database(std::make_unique<MemoryDatabase>(reads));
+  database.store(makeObject("histo", 1));
+
+  std::unique_ptr<MonitorObject> first(database.retrieve("task", "histo"));
+  BOOST_REQUIRE(first);
+  BOOST_CHECK_EQUAL(entries(first.get()), 1);
+  BOOST_CHECK(first->isIsOwner());
+  // the copies given to the callers are independent of the cached object
+  dynamic_cast<TH1F*>(first->getObject())->Fill(1);
+  std::unique_ptr<MonitorObject> second(database.retrieve("task", "histo"));
+  BOOST_CHECK_EQUAL(entries(second.get()), 1);
+  // the JSON is made from the cached object
+  std::string json = database.retrieveJson("task", "histo");
+  BOOST_CHECK(json.find("fEntries") != std::string::npos);
+  BOOST_CHECK_EQUAL(database.retrieveJson("task", "histo"), json);
+  BOOST_CHECK_EQUAL(reads, 1);
+
+  // a new version is read from the database
+  database.store(makeObject("histo", 2));
+  std::unique_ptr<MonitorObject> third(database.retrieve("task", "histo"));
+  BOOST_CHECK_EQUAL(entries(third.get()), 2);
+  BOOST_CHECK(database.retrieveJson("task", "histo") != json);
+  BOOST_CHECK_EQUAL(reads, 2);
+
+  database.truncate("task", "histo");
+  BOOST_CHECK(database.retrieve("task", "histo") == nullptr);
+  BOOST_CHECK(database.retrieveJson("task", "histo").empty());
+  BOOST_CHECK_EQUAL(reads, 4); // missing objects are not cached
+
+  auto statistics = database.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.hits, 4);
+  BOOST_CHECK_EQUAL(statistics.misses, 4);
+  BOOST_CHECK_EQUAL(statistics.entries, 0);
+  BOOST_CHECK_EQUAL(statistics.bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(cache_time_to_live)
+{
+  int reads = 0;
+  CachedDatabase database(std::make_unique<MemoryDatabase>(reads), CachedDatabase::defaultMemoryBudget,
+                          std::chrono::milliseconds(50));
+  database.store(makeObject("histo", 1));
+
+  delete database.retrieve("task", "histo");
+  delete database.retrieve("task", "histo");
+  BOOST_CHECK_EQUAL(reads, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  delete database.retrieve("task", "histo");
+  BOOST_CHECK_EQUAL(reads, 2);
+  BOOST_CHECK_EQUAL(database.getStatistics().expirations, 1);
+}
+
+BOOST_AUTO_TEST_CASE(cache_memory_budget)
+{
+  int reads = 0;
+  auto backend = std::make_unique<MemoryDatabase>(reads);
+  for (auto name : { "a", "b", "c" }) {
+    backend->store(makeObject(name, 1, 1000)); // ~4 kB each
+  }
+  CachedDatabase database(std::move(backend), 10000);
+
+  delete database.retrieve("task", "a");
+  delete database.retrieve("task", "b");
+  delete database.retrieve("task", "a"); // b is now the least recently used
+  delete database.retrieve("task", "c"); // evicts b
+  BOOST_CHECK_EQUAL(reads, 3);
+  BOOST_CHECK_EQUAL(database.getStatistics().evictions, 1);
+  BOOST_CHECK_EQUAL(database.getStatistics().entries, 2);
+  BOOST_CHECK_LE(database.getStatistics().bytes, 10000);
+
+  delete database.retrieve("task", "a");
+  delete database.retrieve("task", "c");
+  BOOST_CHECK_EQUAL(reads, 3);
+  delete database.retrieve("task", "b");
+  BOOST_CHECK_EQUAL(reads, 4);
+
+  database.clear();
+  BOOST_CHECK_EQUAL(database.getStatistics().entries, 0);
+  BOOST_CHECK_EQUAL(database.getStatistics().bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(cache_retrieve_many)
+{
+  int reads = 0;
+  CachedDatabase database(std::make_unique<MemoryDatabase>(reads));
+  database.store(makeObject("a", 1));
+  database.store(makeObject("b", 2));
+  database.store(makeObject("c", 3));
+
+  delete database.retrieve("task", "b");
+  BOOST_CHECK_EQUAL(reads, 1);
+
+  // only a, c and the missing one are read, the order of the request is kept
+  auto objects = database.retrieveMany("task", { "c", "missing", "b", "a" });
+  BOOST_CHECK_EQUAL(reads, 4);
+  BOOST_REQUIRE_EQUAL(objects.size(), 3);
+  BOOST_CHECK_EQUAL(objects[0]->getName(), "c");
+  BOOST_CHECK_EQUAL(objects[1]->getName(), "b");
+  BOOST_CHECK_EQUAL(objects[2]->getName(), "a");
+  BOOST_CHECK_EQUAL(entries(objects[1].get()), 2);
+
+  objects = database.retrieveMany("task", { "a", "b", "c" });
+  BOOST_CHECK_EQUAL(reads, 4);
+  BOOST_CHECK_EQUAL(objects.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(cache_store_async)
+{
+  int reads = 0;
+  auto slowDatabase = std::make_unique<SlowDatabase>(reads);
+  SlowDatabase* slow = slowDatabase.get();
+  CachedDatabase database(std::move(slowDatabase), CachedDatabase::defaultMemoryBudget, std::chrono::milliseconds(0));
+  database.store(makeObject("histo", 1));
+  delete database.retrieve("task", "histo");
+
+  // the previous version is read and cached again while the new one is being stored
+  auto stored = database.storeAsync(makeObject("histo", 2));
+  std::unique_ptr<MonitorObject> during(database.retrieve("task", "histo"));
+  BOOST_CHECK_EQUAL(entries(during.get()), 1);
+  BOOST_CHECK_EQUAL(reads, 2);
+
+  // it is invalidated once the storage is over, despite the infinite time to live
+  slow->complete();
+  stored.get();
+  std::unique_ptr<MonitorObject> after(database.retrieve("task", "histo"));
+  BOOST_CHECK_EQUAL(entries(after.get()), 2);
+  BOOST_CHECK_EQUAL(reads, 3);
+}
+
+} // namespace o2::quality_control::repository
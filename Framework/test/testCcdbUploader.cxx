@@ -0,0 +1,211 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testCcdbUploader.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/CcdbUploader.h"
+
+#define BOOST_TEST_MODULE CcdbUploader test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Common/Exceptions.h>
+#include <TH1F.h>
+#include <TMessage.h>
+
+using namespace AliceO2::Common;
+
+namespace o2::quality_control::repository
+{
+
+/// \brief Minimal HTTP/1.1 server standing in for the CCDB.
+/// It answers every request with 201, or 500 if the URL contains "/fail/", after a short delay. It keeps the
+/// connections open, as the CCDB server does.
+class StandInServer
+{
+ public:
+  StandInServer()
+  {
+    mSocket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0; // any free port
+    BOOST_REQUIRE(bind(mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    BOOST_REQUIRE(listen(mSocket, 16) == 0);
+    socklen_t length = sizeof(address);
+    getsockname(mSocket, reinterpret_cast<sockaddr*>(&address), &length);
+    mPort = ntohs(address.sin_port);
+    mAcceptor = std::thread([this] { accept(); });
+  }
+
+  ~StandInServer()
+  {
+    shutdown(mSocket, SHUT_RDWR); // unblocks accept()
+    mAcceptor.join();
+    for (auto& connection : mConnections) {
+      connection.join();
+    }
+    close(mSocket);
+  }
+
+  std::string getUrl() const { return "127.0.0.1:" + std::to_string(mPort); }
+
+  std::atomic<int> connections{ 0 };
+  std::atomic<int> requests{ 0 };
+  std::atomic<int> inFlight{ 0 };
+  std::atomic<int> maxInFlight{ 0 };
+  std::atomic<size_t> bytes{ 0 };
+
+ private:
+  void accept()
+  {
+    while (true) {
+      int connection = ::accept(mSocket, nullptr, nullptr);
+      if (connection < 0) {
+        return;
+      }
+      connections++;
+      mConnections.emplace_back([this, connection] { serve(connection); });
+    }
+  }
+
+  void serve(int connection)
+  {
+    std::string buffer;
+    char chunk[65536];
+    while (true) {
+      // headers
+      size_t headersEnd;
+      while ((headersEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+          close(connection);
+          return;
+        }
+        buffer.append(chunk, received);
+      }
+      std::string headers = buffer.substr(0, headersEnd);
+      std::string lowerHeaders = headers;
+      std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(), ::tolower);
+      size_t contentLength = 0;
+      if (auto position = lowerHeaders.find("content-length:"); position != std::string::npos) {
+        contentLength = std::stoul(headers.substr(position + 15));
+      }
+      // body
+      while (buffer.size() < headersEnd + 4 + contentLength) {
+        ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+          close(connection);
+          return;
+        }
+        buffer.append(chunk, received);
+      }
+      buffer.erase(0, headersEnd + 4 + contentLength);
+
+      int current = ++inFlight;
+      int previousMax = maxInFlight;
+      while (current > previousMax && !maxInFlight.compare_exchange_weak(previousMax, current)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      inFlight--;
+      requests++;
+      bytes += contentLength;
+
+      std::string firstLine = headers.substr(0, headers.find("\r\n"));
+      std::string response = firstLine.find("/fail/") != std::string::npos
+                               ? "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n"
+                               : "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n";
+      send(connection, response.data(), response.size(), MSG_NOSIGNAL);
+    }
+  }
+
+  int mSocket;
+  int mPort;
+  std::thread mAcceptor;
+  std::vector<std::thread> mConnections;
+};
+
+std::unique_ptr<TMessage> serialize(int bins)
+{
+  TH1F histo("histo", "histo", bins, 0, bins);
+  histo.SetDirectory(nullptr);
+  auto message = std::make_unique<TMessage>(kMESS_OBJECT);
+  message->WriteObjectAny(&histo, histo.IsA());
+  return message;
+}
+
+BOOST_AUTO_TEST_CASE(uploader_concurrent_uploads)
+{
+  StandInServer server;
+  {
+    CcdbUploader uploader(4, 16);
+    BOOST_CHECK_EQUAL(uploader.getNumberOfConnections(), 4);
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 40; i++) {
+      std::string url = server.getUrl() + "/task/histo" + std::to_string(i) + "/1/2/quality=1/";
+      futures.push_back(uploader.upload(url, "histo", serialize(100)));
+    }
+    for (auto& future : futures) {
+      BOOST_CHECK_NO_THROW(future.get());
+    }
+    BOOST_CHECK_EQUAL(server.requests, 40);
+  }
+  // persistent connections : at most one per connection of the uploader, but several requests in flight
+  BOOST_CHECK_LE(server.connections, 4);
+  BOOST_CHECK_GT(server.maxInFlight, 1);
+  BOOST_CHECK_LE(server.maxInFlight, 4);
+}
+
+BOOST_AUTO_TEST_CASE(uploader_large_object)
+{
+  StandInServer server;
+  CcdbUploader uploader(2, 4);
+  auto message = serialize(250000); // ~1 MB
+  size_t size = message->Length();
+  auto future = uploader.upload(server.getUrl() + "/task/large/1/2/", "large", std::move(message));
+  BOOST_CHECK_NO_THROW(future.get());
+  BOOST_CHECK_GT(server.bytes, size); // the object and the multipart envelope
+}
+
+BOOST_AUTO_TEST_CASE(uploader_failures)
+{
+  StandInServer server;
+  CcdbUploader uploader(2, 4);
+  auto failed = uploader.upload(server.getUrl() + "/fail/histo/1/2/", "histo", serialize(10));
+  auto succeeded = uploader.upload(server.getUrl() + "/task/histo/1/2/", "histo", serialize(10));
+  BOOST_CHECK_THROW(failed.get(), DatabaseException);
+  BOOST_CHECK_NO_THROW(succeeded.get());
+
+  // nobody listening
+  CcdbUploader unreachable(1, 1);
+  auto refused = unreachable.upload("127.0.0.1:1/task/histo/1/2/", "histo", serialize(10));
+  BOOST_CHECK_THROW(refused.get(), DatabaseException);
+
+  uploader.flush();
+  BOOST_CHECK_EQUAL(server.requests, 2);
+}
+
+} // namespace o2::quality_control::repository
@@ -18,7 +18,9 @@
 #include <cassert>
 #include <iostream>
 
+#include <QualityControl/CachedDatabase.h>
 #include <QualityControl/CcdbDatabase.h>
+#include <QualityControl/LocalDatabase.h>
 #include <QualityControl/MonitorObject.h>
 #include <TH1F.h>
 #include <fcntl.h>
@@ -48,6 +50,18 @@ BOOST_AUTO_TEST_CASE(db_factory_test)
   std::unique_ptr<DatabaseInterface> database3 = DatabaseFactory::create("CCDB");
   BOOST_CHECK(database3);
   BOOST_CHECK(dynamic_cast<CcdbDatabase*>(database3.get()));
+
+  std::unique_ptr<DatabaseInterface> database4 = DatabaseFactory::create("Local");
+  BOOST_CHECK(database4);
+  BOOST_CHECK(dynamic_cast<LocalDatabase*>(database4.get()));
+
+  std::unique_ptr<DatabaseInterface> database5 = DatabaseFactory::create("Local", true);
+  BOOST_CHECK(database5);
+  BOOST_CHECK(dynamic_cast<CachedDatabase*>(database5.get()));
+
+  std::unique_ptr<DatabaseInterface> database6 = nullptr;
+  BOOST_CHECK_EXCEPTION(database6 = DatabaseFactory::create("asf", true), AliceO2::Common::FatalException, do_nothing);
+  BOOST_CHECK(!database6);
 }
 
 BOOST_AUTO_TEST_CASE(db_ccdb_listing)
@@ -93,6 +107,26 @@ BOOST_AUTO_TEST_CASE(db_ccdb_listing)
   // test retrieve object
   MonitorObject* mo1_retrieved = ccdb->retrieve("functional_test", "object1");
   BOOST_CHECK(mo1_retrieved != nullptr);
+
+  // test retrieve several objects at once, the missing ones are skipped
+  auto objects = ccdb->retrieveMany("functional_test", { "object1", "missing", "path/to/object3" });
+  BOOST_REQUIRE_EQUAL(objects.size(), 2);
+  BOOST_CHECK_EQUAL(objects[0]->getName(), "object1");
+  BOOST_CHECK_EQUAL(objects[1]->getName(), "path/to/object3");
+  BOOST_CHECK(objects[0]->isIsOwner() && objects[1]->isIsOwner()); // their histograms are deleted along with them
+  auto allObjects = ccdb->retrieveAll("functional_test");
+  BOOST_CHECK_GE(allObjects.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(db_ccdb_storage_url)
+{
+  // the layout of the URLs built by CcdbApi::store, which storeAsync must post to
+  BOOST_CHECK_EQUAL(CcdbDatabase::getStorageUrl("http://ccdb:8080", "task/path/to/histo", {}, 1000, 2000),
+                    "http://ccdb:8080/task/path/to/histo/1000/2000/");
+  BOOST_CHECK_EQUAL(
+    CcdbDatabase::getStorageUrl("http://ccdb:8080", "task/histo", { { "quality", "3" }, { "detector", "TST" } }, 1000,
+                                2000),
+    "http://ccdb:8080/task/histo/1000/2000/detector=TST/quality=3/");
 }
 
 /*
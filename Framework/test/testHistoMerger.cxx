@@ -0,0 +1,188 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testHistoMerger.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/HistoMerger.h"
+#include "QualityControl/CycleHeader.h"
+#include "QualityControl/MonitorObjectsSerializer.h"
+
+#define BOOST_TEST_MODULE HistoMerger test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <Headers/DataHeader.h>
+#include <Headers/Stack.h>
+#include <TH1F.h>
+#include <chrono>
+#include <thread>
+
+using namespace o2::framework;
+using SubSpecificationType = o2::header::DataHeader::SubSpecificationType;
+
+namespace o2::quality_control::core
+{
+
+namespace
+{
+
+/// An array of MonitorObjects as received by a merger from the input with the given SubSpec.
+/// The message has a CycleHeader if the cycle is not negative.
+struct Message {
+  Message(SubSpecificationType subSpec, const std::vector<std::pair<std::string, double>>& histos, int cycle = -1)
+  {
+    TObjArray array;
+    array.SetOwner(true);
+    for (const auto& [name, value] : histos) {
+      auto* histo = new TH1F(name.c_str(), name.c_str(), 10, 0, 10);
+      histo->SetDirectory(nullptr);
+      histo->Fill(value);
+      auto* mo = new MonitorObject(histo, "task");
+      mo->setIsOwner(true);
+      array.Add(mo);
+    }
+    MonitorObjectsSerializer serializer;
+    const TBufferFile& buffer = serializer.serialize(array);
+    payload.assign(buffer.Buffer(), buffer.Buffer() + buffer.Length());
+
+    o2::header::DataHeader dataHeader;
+    dataHeader.payloadSerializationMethod = o2::header::gSerializationMethodNone;
+    dataHeader.payloadSize = payload.size();
+    dataHeader.subSpecification = subSpec;
+    if (cycle < 0) {
+      headerStack = std::make_unique<o2::header::Stack>(dataHeader);
+    } else {
+      headerStack = std::make_unique<o2::header::Stack>(dataHeader, CycleHeader{ static_cast<uint64_t>(cycle) });
+    }
+  }
+
+  DataRef ref() const
+  {
+    return DataRef{ nullptr, reinterpret_cast<const char*>(headerStack->data()), payload.data() };
+  }
+
+  std::vector<char> payload;
+  std::unique_ptr<o2::header::Stack> headerStack;
+};
+
+double entriesOf(const HistoMerger& merger, const std::string& name)
+{
+  auto* mo = dynamic_cast<MonitorObject*>(merger.getMergedObjects().FindObject(name.c_str()));
+  BOOST_REQUIRE_MESSAGE(mo != nullptr, "missing " + name);
+  return dynamic_cast<TH1*>(mo->getObject())->GetEntries();
+}
+
+/// Merges a message with a histogram from the given input and cycle.
+void receive(HistoMerger& merger, SubSpecificationType subSpec, int cycle)
+{
+  Message message(subSpec, { { "histo", 1 } }, cycle);
+  merger.merge({ message.ref() });
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(merger_partial_and_reordered_inputs)
+{
+  HistoMerger merger("merger", 1000);
+  merger.configureInputsOutputs("QC", "TST", std::vector<SubSpecificationType>{ 1, 2 }, 0);
+
+  // the second input sends only one of the objects
+  Message first(1, { { "h1", 1 }, { "h2", 2 } });
+  Message second(2, { { "h2", 3 } });
+  merger.merge({ first.ref(), second.ref() });
+  BOOST_REQUIRE_EQUAL(merger.getMergedObjects().GetEntriesFast(), 2);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "h1"), 1);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "h2"), 2);
+
+  // the objects come in another order, with a new one
+  Message third(2, { { "h3", 4 }, { "h1", 5 } });
+  merger.merge({ third.ref() });
+  BOOST_REQUIRE_EQUAL(merger.getMergedObjects().GetEntriesFast(), 3);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "h1"), 2);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "h2"), 2);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "h3"), 1);
+  // the merged objects keep the order in which they were first received
+  BOOST_CHECK_EQUAL(std::string(merger.getMergedObjects().At(0)->GetName()), "h1");
+  BOOST_CHECK_EQUAL(std::string(merger.getMergedObjects().At(2)->GetName()), "h3");
+
+  auto* h1 = dynamic_cast<TH1*>(dynamic_cast<MonitorObject*>(merger.getMergedObjects().At(0))->getObject());
+  BOOST_CHECK_EQUAL(h1->GetBinContent(h1->FindBin(1)), 1);
+  BOOST_CHECK_EQUAL(h1->GetBinContent(h1->FindBin(5)), 1);
+}
+
+BOOST_AUTO_TEST_CASE(merger_cycle_completion)
+{
+  HistoMerger merger("merger", 1000);
+  merger.configureInputsOutputs("QC", "TST", std::vector<SubSpecificationType>{ 1, 2 }, 0);
+  merger.setPublicationOnCompletion(true);
+
+  receive(merger, 1, 0);
+  BOOST_CHECK(!merger.preparePublication());
+  receive(merger, 2, 0);
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 1);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "histo"), 2);
+  BOOST_CHECK(!merger.preparePublication());
+}
+
+BOOST_AUTO_TEST_CASE(merger_cycle_lagging_input)
+{
+  HistoMerger merger("merger", 1000);
+  merger.configureInputsOutputs("QC", "TST", std::vector<SubSpecificationType>{ 1, 2 }, 0);
+  merger.setPublicationOnCompletion(true);
+
+  // the first input is ahead, the cycles are published as the second one catches up
+  for (int cycle = 0; cycle < 3; cycle++) {
+    receive(merger, 1, cycle);
+    BOOST_CHECK(!merger.preparePublication());
+  }
+  receive(merger, 2, 0);
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 1);
+  receive(merger, 2, 1);
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 2);
+
+  // the message of the cycle 2 of the second input is lost, its cycle 3 completes the cycle 3
+  receive(merger, 1, 3);
+  BOOST_CHECK(!merger.preparePublication());
+  receive(merger, 2, 3);
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(merger_cycle_timeout)
+{
+  HistoMerger merger("merger", 1);
+  merger.configureInputsOutputs("QC", "TST", std::vector<SubSpecificationType>{ 1, 2 }, 0);
+  merger.setPublicationOnCompletion(true);
+
+  receive(merger, 1, 0);
+  BOOST_CHECK(!merger.preparePublication());
+  // the second input is late, what was received is published once the period is over
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 1);
+
+  // its late cycle is merged in the next publication, which waits for both inputs
+  receive(merger, 2, 0);
+  BOOST_CHECK(!merger.preparePublication());
+  receive(merger, 1, 1);
+  BOOST_CHECK(!merger.preparePublication());
+  receive(merger, 2, 1);
+  BOOST_CHECK(merger.preparePublication());
+  BOOST_CHECK_EQUAL(merger.getNextCycle(), 2);
+  BOOST_CHECK_EQUAL(entriesOf(merger, "histo"), 4);
+}
+
+} // namespace o2::quality_control::core
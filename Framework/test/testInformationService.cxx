@@ -0,0 +1,72 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testInformationService.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "../src/InformationService.h"
+
+#define BOOST_TEST_MODULE InformationService test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(information_service_task_json)
+{
+  BOOST_CHECK_EQUAL(InformationService::buildTaskJson("task", {}), "{\"name\":\"task\",\"objects\":[]}");
+  BOOST_CHECK_EQUAL(InformationService::buildTaskJson("task", { "a", "b/c" }),
+                    "{\"name\":\"task\",\"objects\":[{\"id\":\"a\"},{\"id\":\"b/c\"}]}");
+}
+
+BOOST_AUTO_TEST_CASE(information_service_json_escaping)
+{
+  // the quotes, the backslashes and the control characters are escaped, the other characters are kept as they are
+  BOOST_CHECK_EQUAL(InformationService::buildTaskJson("t\"1\\", { "a\nb\tc", std::string("d\x01") + "\x1f" }),
+                    "{\"name\":\"t\\\"1\\\\\",\"objects\":[{\"id\":\"a\\nb\\tc\"},{\"id\":\"d\\u0001\\u001f\"}]}");
+  BOOST_CHECK_EQUAL(InformationService::buildTaskJson("tâche", { "é/ü" }),
+                    "{\"name\":\"tâche\",\"objects\":[{\"id\":\"é/ü\"}]}");
+}
+
+BOOST_AUTO_TEST_CASE(information_service_diff)
+{
+  std::vector<std::string> added, removed;
+  InformationService::diffObjects({}, { "a", "b" }, added, removed);
+  BOOST_CHECK(added == std::vector<std::string>({ "a", "b" }));
+  BOOST_CHECK(removed.empty());
+
+  // the objects are listed in the order of the lists, whatever the order in which they were sent
+  added.clear();
+  removed.clear();
+  InformationService::diffObjects({ "a", "b", "c", "d" }, { "e", "d", "b", "f" }, added, removed);
+  BOOST_CHECK(added == std::vector<std::string>({ "e", "f" }));
+  BOOST_CHECK(removed == std::vector<std::string>({ "a", "c" }));
+
+  added.clear();
+  removed.clear();
+  InformationService::diffObjects({ "a", "b" }, { "b", "a" }, added, removed);
+  BOOST_CHECK(added.empty());
+  BOOST_CHECK(removed.empty());
+
+  added.clear();
+  InformationService::diffObjects({ "a", "b" }, {}, added, removed);
+  BOOST_CHECK(added.empty());
+  BOOST_CHECK(removed == std::vector<std::string>({ "a", "b" }));
+}
+
+BOOST_AUTO_TEST_CASE(information_service_delta_json)
+{
+  BOOST_CHECK_EQUAL(InformationService::buildTaskDeltaJson(1000, 42, "task", { "e\"" }, {}),
+                    "{\"epoch\":1000,\"sequence\":42,\"name\":\"task\",\"added\":[{\"id\":\"e\\\"\"}],\"removed\":[]}");
+  BOOST_CHECK_EQUAL(InformationService::buildTaskDeltaJson(1001, 0, "task", {}, { "a", "c" }),
+                    "{\"epoch\":1001,\"sequence\":0,\"name\":\"task\",\"added\":[],"
+                    "\"removed\":[{\"id\":\"a\"},{\"id\":\"c\"}]}");
+}
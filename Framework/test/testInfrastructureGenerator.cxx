@@ -27,7 +27,7 @@ BOOST_AUTO_TEST_CASE(qc_factory_local_test)
     BOOST_REQUIRE_EQUAL(workflow.size(), 1);
 
     BOOST_CHECK_EQUAL(workflow[0].name, "skeletonTask");
-    BOOST_CHECK_EQUAL(workflow[0].inputs.size(), 1);
+    BOOST_CHECK_EQUAL(workflow[0].inputs.size(), 2); // data + cycle timer
     BOOST_CHECK_EQUAL(workflow[0].outputs.size(), 1);
     BOOST_CHECK_EQUAL(workflow[0].outputs[0].subSpec, 1);
   }
@@ -38,7 +38,7 @@ BOOST_AUTO_TEST_CASE(qc_factory_local_test)
     BOOST_REQUIRE_EQUAL(workflow.size(), 1);
 
     BOOST_CHECK_EQUAL(workflow[0].name, "skeletonTask");
-    BOOST_CHECK_EQUAL(workflow[0].inputs.size(), 1);
+    BOOST_CHECK_EQUAL(workflow[0].inputs.size(), 2); // data + cycle timer
     BOOST_CHECK_EQUAL(workflow[0].outputs.size(), 1);
     BOOST_CHECK_EQUAL(workflow[0].outputs[0].subSpec, 2);
   }
@@ -83,7 +83,7 @@ BOOST_AUTO_TEST_CASE(qc_factory_remote_test)
     workflow.begin(), workflow.end(),
     [](const DataProcessorSpec& d) {
       return d.name == "abcTask" &&
-             d.inputs.size() == 1 &&
+             d.inputs.size() == 2 &&
              d.outputs.size() == 1;
     });
   BOOST_CHECK(taskRunnerAbcTask != workflow.end());
@@ -96,4 +96,54 @@ BOOST_AUTO_TEST_CASE(qc_factory_remote_test)
              d.outputs.size() == 1;
     });
   BOOST_CHECK(checkerAbcTask != workflow.end());
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(qc_factory_merger_tree_test)
+{
+  std::string configFilePath = std::string("json:/") + getenv("QUALITYCONTROL_ROOT") + "/test/testMergerTree.json";
+  auto workflow = InfrastructureGenerator::generateRemoteInfrastructure(configFilePath);
+
+  // treeTask : 7 machines, fan-in of 3 then 2 -> 3 + 1 + 1 mergers and a checker
+  // flatTask : 3 machines, fan-in of 4 -> 1 merger and a checker
+  BOOST_REQUIRE_EQUAL(workflow.size(), 8);
+
+  auto getSubSpecs = [](const std::vector<InputSpec>& inputs) {
+    std::vector<header::DataHeader::SubSpecificationType> subSpecs;
+    for (const auto& input : inputs) {
+      subSpecs.push_back(DataSpecUtils::asConcreteDataMatcher(input).subSpec);
+    }
+    return subSpecs;
+  };
+  auto checkMerger = [&](std::string name, std::vector<header::DataHeader::SubSpecificationType> inputs,
+                         header::DataHeader::SubSpecificationType output) {
+    auto merger = std::find_if(workflow.begin(), workflow.end(),
+                               [&name](const DataProcessorSpec& d) { return d.name == name; });
+    BOOST_REQUIRE_MESSAGE(merger != workflow.end(), "missing " + name);
+    auto subSpecs = getSubSpecs(merger->inputs);
+    BOOST_CHECK_EQUAL_COLLECTIONS(subSpecs.begin(), subSpecs.end(), inputs.begin(), inputs.end());
+    BOOST_REQUIRE_EQUAL(merger->outputs.size(), 1);
+    BOOST_CHECK_EQUAL(merger->outputs[0].subSpec, output);
+  };
+
+  // the local tasks publish with SubSpecs 1 to 7, the intermediate mergers use the next ones
+  checkMerger("treeTask-merger-1-0", { 1, 2, 3 }, 8);
+  checkMerger("treeTask-merger-1-1", { 4, 5 }, 9);
+  checkMerger("treeTask-merger-1-2", { 6, 7 }, 10);
+  // the third input of the second layer would be alone in its merger, it goes to the last one
+  checkMerger("treeTask-merger-2-0", { 8, 9 }, 11);
+  checkMerger("treeTask-merger", { 11, 10 }, 0);
+  checkMerger("flatTask-merger", { 1, 2, 3 }, 0);
+
+  // the mergers of the first layer tell which machines they merge, for their placement
+  auto getMachines = [&](std::string name) {
+    auto merger = std::find_if(workflow.begin(), workflow.end(),
+                               [&name](const DataProcessorSpec& d) { return d.name == name; });
+    auto option = std::find_if(merger->options.begin(), merger->options.end(),
+                               [](const ConfigParamSpec& o) { return o.name == "machines"; });
+    return option == merger->options.end() ? std::string() : std::string(option->defaultValue.get<const char*>());
+  };
+  BOOST_CHECK_EQUAL(getMachines("treeTask-merger-1-0"), "o2flp1,o2flp2,o2flp3");
+  BOOST_CHECK_EQUAL(getMachines("treeTask-merger-1-2"), "o2flp6,o2flp7");
+  BOOST_CHECK_EQUAL(getMachines("treeTask-merger-2-0"), "");
+  BOOST_CHECK_EQUAL(getMachines("treeTask-merger"), "");
+}
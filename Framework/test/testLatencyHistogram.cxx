@@ -0,0 +1,79 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testLatencyHistogram.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/LatencyHistogram.h"
+
+#define BOOST_TEST_MODULE LatencyHistogram test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <limits>
+
+namespace o2::quality_control::core
+{
+
+BOOST_AUTO_TEST_CASE(latency_histogram_percentiles)
+{
+  LatencyHistogram histogram;
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(50), 0);
+
+  for (uint64_t value = 1; value <= 100; value++) {
+    histogram.record(value);
+  }
+  // exact below 128
+  BOOST_CHECK_EQUAL(histogram.getCount(), 100);
+  BOOST_CHECK_EQUAL(histogram.getMin(), 1);
+  BOOST_CHECK_EQUAL(histogram.getMax(), 100);
+  BOOST_CHECK_CLOSE(histogram.getMean(), 50.5, 0.001);
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(0), 1);
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(50), 50);
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(99), 99);
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(100), 100);
+
+  histogram.reset();
+  for (uint64_t value = 1; value <= 1000000; value++) {
+    histogram.record(value);
+  }
+  for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+    double exact = percentile * 10000;
+    auto value = histogram.getValueAtPercentile(percentile);
+    BOOST_CHECK_GE(value, exact);
+    BOOST_CHECK_LE(value, exact * 1.016);
+  }
+  BOOST_CHECK_EQUAL(histogram.getValueAtPercentile(100), 1000000);
+}
+
+BOOST_AUTO_TEST_CASE(latency_histogram_add)
+{
+  LatencyHistogram fast, slow;
+  for (int i = 0; i < 990; i++) {
+    fast.record(1000);
+  }
+  for (int i = 0; i < 10; i++) {
+    slow.record(5000000);
+  }
+  slow.record(std::numeric_limits<uint64_t>::max());
+  fast.add(slow);
+
+  BOOST_CHECK_EQUAL(fast.getCount(), 1001);
+  BOOST_CHECK_EQUAL(fast.getMin(), 1000);
+  BOOST_CHECK_EQUAL(fast.getMax(), std::numeric_limits<uint64_t>::max());
+  BOOST_CHECK_LE(fast.getValueAtPercentile(90) - 1000, 16);
+  BOOST_CHECK_GE(fast.getValueAtPercentile(99.9), 5000000);
+  BOOST_CHECK_LE(fast.getValueAtPercentile(99.9), 5000000 * 1.016);
+  BOOST_CHECK_EQUAL(fast.getValueAtPercentile(100), std::numeric_limits<uint64_t>::max());
+}
+
+} // namespace o2::quality_control::core
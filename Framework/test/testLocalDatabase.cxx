@@ -0,0 +1,204 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testLocalDatabase.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/LocalDatabase.h"
+
+#define BOOST_TEST_MODULE LocalDatabase test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <TNamed.h>
+#include "Common/Exceptions.h"
+#include "QualityControl/MonitorObject.h"
+
+using namespace o2::quality_control::core;
+
+namespace o2::quality_control::repository
+{
+
+/// A new empty directory, removed with its content at the end of the test.
+class TemporaryDirectory
+{
+ public:
+  TemporaryDirectory()
+  {
+    char path[] = "/tmp/qc_local_database_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(path) != nullptr);
+    mPath = path;
+  }
+  ~TemporaryDirectory()
+  {
+    for (const auto& file : list()) {
+      unlink((mPath + "/" + file).c_str());
+    }
+    rmdir(mPath.c_str());
+  }
+
+  std::vector<std::string> list() const
+  {
+    std::vector<std::string> files;
+    DIR* dir = opendir(mPath.c_str());
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        files.emplace_back(entry->d_name);
+      }
+    }
+    closedir(dir);
+    return files;
+  }
+  size_t countSegments() const
+  {
+    auto files = list();
+    return std::count_if(files.begin(), files.end(),
+                         [](const std::string& file) { return file.find("segment-") == 0; });
+  }
+
+  std::string mPath;
+};
+
+std::shared_ptr<MonitorObject> makeObject(const std::string& name, const std::string& version,
+                                          const std::string& task = "task")
+{
+  // the version is put in the title to be able to tell the objects apart once stored
+  return std::make_shared<MonitorObject>(new TNamed(name.c_str(), version.c_str()), task);
+}
+
+std::string getVersion(MonitorObject* mo) { return mo ? mo->getObject()->GetTitle() : ""; }
+
+BOOST_AUTO_TEST_CASE(local_store_retrieve)
+{
+  TemporaryDirectory directory;
+  LocalDatabase database;
+  database.connect({ { "path", directory.mPath } });
+
+  for (int version = 0; version < 5; version++) {
+    database.store(makeObject("a", std::to_string(version)));
+    database.store(makeObject("b", std::to_string(version)));
+  }
+  database.store(makeObject("c", "0", "other_task"));
+
+  std::unique_ptr<MonitorObject> mo(database.retrieve("task", "a"));
+  BOOST_CHECK_EQUAL(getVersion(mo.get()), "4");
+  BOOST_CHECK_EQUAL(mo->getTaskName(), "task");
+  BOOST_CHECK(database.retrieve("task", "missing") == nullptr);
+  BOOST_CHECK(database.retrieveJson("other_task", "c").find("TNamed") != std::string::npos);
+
+  auto latest = database.getLatest("task", "b");
+  BOOST_REQUIRE(latest);
+  std::unique_ptr<MonitorObject> deserialized(LocalDatabase::deserialize(*latest));
+  BOOST_CHECK_EQUAL(getVersion(deserialized.get()), "4");
+
+  auto history = database.getHistory("task", "b");
+  BOOST_REQUIRE_EQUAL(history.size(), 5);
+  for (size_t i = 0; i < history.size(); i++) {
+    std::unique_ptr<MonitorObject> version(LocalDatabase::deserialize(history[i]));
+    BOOST_CHECK_EQUAL(getVersion(version.get()), std::to_string(i));
+  }
+  BOOST_CHECK(database.getHistory("task", "b", history.back().timestamp + 1).empty());
+
+  std::vector<std::string> tasks{ "other_task", "task" };
+  auto listed = database.getListOfTasksWithPublications();
+  BOOST_CHECK_EQUAL_COLLECTIONS(listed.begin(), listed.end(), tasks.begin(), tasks.end());
+  BOOST_CHECK_EQUAL(database.getPublishedObjectNames("task").size(), 2);
+
+  database.truncate("task", "a");
+  BOOST_CHECK(database.retrieve("task", "a") == nullptr);
+  BOOST_CHECK_EQUAL(database.getPublishedObjectNames("task").size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(local_persistence_and_compaction)
+{
+  TemporaryDirectory directory;
+  {
+    LocalDatabase database;
+    // tiny segments, so that the objects are spread over many of them
+    database.connect({ { "path", directory.mPath }, { "segmentSize", "1000" } });
+    for (int version = 0; version < 20; version++) {
+      database.store(makeObject("object" + std::to_string(version % 4), std::to_string(version)));
+    }
+    database.truncate("task", "object3");
+  }
+  size_t segments = directory.countSegments();
+  BOOST_CHECK_GT(segments, 2);
+
+  LocalDatabase database;
+  database.connect({ { "path", directory.mPath }, { "segmentSize", "1000" } });
+  std::unique_ptr<MonitorObject> mo(database.retrieve("task", "object1"));
+  BOOST_CHECK_EQUAL(getVersion(mo.get()), "17");
+  BOOST_CHECK_EQUAL(database.getHistory("task", "object1").size(), 5);
+  BOOST_CHECK(database.retrieve("task", "object3") == nullptr);
+
+  database.compact(2);
+  BOOST_CHECK_LT(directory.countSegments(), segments);
+  BOOST_CHECK_EQUAL(database.getHistory("task", "object1").size(), 2);
+  mo.reset(database.retrieve("task", "object1"));
+  BOOST_CHECK_EQUAL(getVersion(mo.get()), "17");
+
+  database.store(makeObject("object1", "new"));
+  database.disconnect();
+  database.connect({ { "path", directory.mPath } });
+  mo.reset(database.retrieve("task", "object1"));
+  BOOST_CHECK_EQUAL(getVersion(mo.get()), "new");
+  BOOST_CHECK_EQUAL(database.getHistory("task", "object1").size(), 3);
+  BOOST_CHECK_EQUAL(database.getPublishedObjectNames("task").size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(local_incomplete_index)
+{
+  TemporaryDirectory directory;
+  {
+    LocalDatabase database;
+    database.connect({ { "path", directory.mPath } });
+    database.store(makeObject("a", "1"));
+  }
+  // as if the process had been killed while writing a record
+  FILE* index = fopen((directory.mPath + "/index.dat").c_str(), "a");
+  fwrite("incomplete", 1, 10, index);
+  fclose(index);
+
+  {
+    LocalDatabase database;
+    database.connect({ { "path", directory.mPath } });
+    std::unique_ptr<MonitorObject> mo(database.retrieve("task", "a"));
+    BOOST_CHECK_EQUAL(getVersion(mo.get()), "1");
+    database.store(makeObject("a", "2"));
+  }
+  LocalDatabase database;
+  database.connect({ { "path", directory.mPath } });
+  std::unique_ptr<MonitorObject> mo(database.retrieve("task", "a"));
+  BOOST_CHECK_EQUAL(getVersion(mo.get()), "2");
+}
+
+BOOST_AUTO_TEST_CASE(local_exclusive_connection)
+{
+  TemporaryDirectory directory;
+  LocalDatabase database;
+  database.connect({ { "path", directory.mPath } });
+
+  LocalDatabase other;
+  BOOST_CHECK_THROW(other.connect({ { "path", directory.mPath } }), AliceO2::Common::DatabaseException);
+
+  // the directory can be opened again once the first connection is closed
+  database.disconnect();
+  BOOST_CHECK_NO_THROW(other.connect({ { "path", directory.mPath } }));
+  BOOST_CHECK_THROW(database.connect({ { "path", directory.mPath } }), AliceO2::Common::DatabaseException);
+}
+
+} // namespace o2::quality_control::repository
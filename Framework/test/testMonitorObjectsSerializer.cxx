@@ -0,0 +1,91 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testMonitorObjectsSerializer.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/MonitorObjectsSerializer.h"
+
+#define BOOST_TEST_MODULE MonitorObjectsSerializer test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <Common/Exceptions.h>
+#include <Headers/DataHeader.h>
+#include <Headers/Stack.h>
+#include <TH1F.h>
+#include <TObjString.h>
+#include <vector>
+
+using namespace o2::framework;
+
+namespace o2::quality_control::core
+{
+
+BOOST_AUTO_TEST_CASE(serializer_round_trip)
+{
+  TObjArray array;
+  array.SetOwner(true);
+  auto* histo = new TH1F("histo", "histo", 100, 0, 100);
+  histo->SetDirectory(nullptr);
+  histo->Fill(42, 3);
+  array.Add(new MonitorObject(histo, "task"));
+  array.Add(new MonitorObject(new TObjString("string"), "task"));
+  array.Add(new TObjString("not a MonitorObject"));
+
+  MonitorObjectsSerializer serializer;
+  // the second serialization reuses the buffer of the first one, which is rewritten from its beginning
+  const TBufferFile& firstBuffer = serializer.serialize(array);
+  std::vector<char> firstPayload(firstBuffer.Buffer(), firstBuffer.Buffer() + firstBuffer.Length());
+  const TBufferFile& buffer = serializer.serialize(array);
+  BOOST_CHECK_EQUAL(&buffer, &firstBuffer);
+  BOOST_CHECK(std::vector<char>(buffer.Buffer(), buffer.Buffer() + buffer.Length()) == firstPayload);
+
+  o2::header::DataHeader dataHeader;
+  dataHeader.payloadSerializationMethod = o2::header::gSerializationMethodNone;
+  dataHeader.payloadSize = buffer.Length();
+  o2::header::Stack headerStack{ dataHeader };
+  DataRef ref{ nullptr, reinterpret_cast<const char*>(headerStack.data()), buffer.Buffer() };
+
+  MonitorObjectsView view(ref);
+  BOOST_REQUIRE_EQUAL(view.size(), 3);
+  // the objects can be read in any order
+  auto second = view.get(1);
+  BOOST_REQUIRE(second != nullptr);
+  BOOST_CHECK_EQUAL(second->getName(), "string");
+  auto first = view.get(0);
+  BOOST_REQUIRE(first != nullptr);
+  BOOST_CHECK_EQUAL(first->getName(), "histo");
+  BOOST_CHECK_EQUAL(first->getTaskName(), "task");
+  BOOST_CHECK(first->isIsOwner());
+  auto* histoCopy = dynamic_cast<TH1F*>(first->getObject());
+  BOOST_REQUIRE(histoCopy != nullptr);
+  BOOST_CHECK_EQUAL(histoCopy->GetBinContent(histoCopy->FindBin(42)), 3);
+  BOOST_CHECK(view.get(2) == nullptr);
+
+  auto all = MonitorObjectsSerializer::deserialize(ref);
+  BOOST_CHECK_EQUAL(all->GetEntries(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(serializer_invalid_message)
+{
+  char payload[] = "definitely not monitor objects";
+  o2::header::DataHeader dataHeader;
+  dataHeader.payloadSerializationMethod = o2::header::gSerializationMethodNone;
+  dataHeader.payloadSize = sizeof(payload);
+  o2::header::Stack headerStack{ dataHeader };
+  DataRef ref{ nullptr, reinterpret_cast<const char*>(headerStack.data()), payload };
+
+  BOOST_CHECK_THROW(MonitorObjectsView view(ref), AliceO2::Common::FatalException);
+}
+
+} // namespace o2::quality_control::core
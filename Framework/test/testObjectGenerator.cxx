@@ -0,0 +1,98 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testObjectGenerator.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/ObjectGenerator.h"
+
+#define BOOST_TEST_MODULE ObjectGenerator test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <TDirectory.h>
+#include <TGraph.h>
+#include <TH2F.h>
+#include <TTree.h>
+#include <Common/Exceptions.h>
+
+namespace o2::quality_control::core
+{
+
+BOOST_AUTO_TEST_CASE(generator_sizes)
+{
+  ObjectGenerator generator;
+  for (auto typeName : { "TH1F", "TH2F", "TH3F", "TProfile", "TGraph", "TTree" }) {
+    auto type = ObjectGenerator::getType(typeName);
+    for (size_t size : { 10000, 1000000 }) {
+      std::unique_ptr<TObject> object(generator.generate(type, "object", size));
+      BOOST_TEST_CONTEXT(typeName << " of " << size << " bytes")
+      {
+        BOOST_CHECK_EQUAL(object->ClassName(), std::string(typeName));
+        BOOST_CHECK_EQUAL(object->GetName(), std::string("object"));
+        BOOST_CHECK_CLOSE(double(ObjectGenerator::getSerializedSize(*object)), double(size), 5);
+      }
+    }
+  }
+  // the smallest object possible
+  std::unique_ptr<TObject> tiny(generator.generate(ObjectGenerator::Type::TH1F, "tiny", 1));
+  BOOST_CHECK_EQUAL(dynamic_cast<TH1*>(tiny.get())->GetNbinsX(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(generator_cells_and_contents)
+{
+  ObjectGenerator generator(1);
+  std::unique_ptr<TH2F> histo(dynamic_cast<TH2F*>(
+    generator.generateCells(ObjectGenerator::Type::TH2F, "histo", 10000, ObjectGenerator::Content::Empty)));
+  BOOST_REQUIRE(histo);
+  BOOST_CHECK_EQUAL(histo->GetNbinsX(), 100);
+  BOOST_CHECK_EQUAL(histo->GetNbinsY(), 100);
+  BOOST_CHECK_EQUAL(histo->GetEntries(), 0);
+  BOOST_CHECK(histo->GetDirectory() == nullptr);
+  BOOST_CHECK(gDirectory->FindObject("histo") == nullptr);
+
+  std::unique_ptr<TH1> smooth(dynamic_cast<TH1*>(
+    generator.generateCells(ObjectGenerator::Type::TH1F, "smooth", 101, ObjectGenerator::Content::Smooth)));
+  BOOST_CHECK_EQUAL(smooth->GetMaximumBin(), 51);
+  BOOST_CHECK_GT(smooth->GetBinContent(51), smooth->GetBinContent(30));
+
+  std::unique_ptr<TGraph> sparse(dynamic_cast<TGraph*>(
+    generator.generateCells(ObjectGenerator::Type::TGraph, "sparse", 10000, ObjectGenerator::Content::Sparse)));
+  BOOST_REQUIRE_EQUAL(sparse->GetN(), 10000);
+  int filled = 0;
+  for (int i = 0; i < sparse->GetN(); i++) {
+    filled += sparse->GetY()[i] != 0;
+  }
+  BOOST_CHECK(filled > 50 && filled < 200);
+
+  std::unique_ptr<TTree> tree(dynamic_cast<TTree*>(
+    generator.generateCells(ObjectGenerator::Type::TTree, "tree", 5000, ObjectGenerator::Content::Random)));
+  BOOST_CHECK_EQUAL(tree->GetEntries(), 5000);
+  BOOST_CHECK(tree->GetDirectory() == nullptr);
+
+  // the same seed gives the same objects
+  ObjectGenerator other(1);
+  std::unique_ptr<TObject> first(generator.generateCells(ObjectGenerator::Type::TH1F, "a", 100));
+  std::unique_ptr<TObject> second(ObjectGenerator(1).generateCells(ObjectGenerator::Type::TH1F, "a", 100));
+  std::unique_ptr<TObject> third(other.generateCells(ObjectGenerator::Type::TH1F, "a", 100));
+  BOOST_CHECK_EQUAL(dynamic_cast<TH1*>(second.get())->GetBinContent(10),
+                    dynamic_cast<TH1*>(third.get())->GetBinContent(10));
+  BOOST_CHECK_NE(dynamic_cast<TH1*>(first.get())->GetBinContent(10),
+                 dynamic_cast<TH1*>(second.get())->GetBinContent(10));
+
+  BOOST_CHECK(ObjectGenerator::getContent("smooth") == ObjectGenerator::Content::Smooth);
+  BOOST_CHECK_THROW(ObjectGenerator::getType("TH1D"), AliceO2::Common::FatalException);
+  BOOST_CHECK_THROW(ObjectGenerator::getContent("noise"), AliceO2::Common::FatalException);
+}
+
+} // namespace o2::quality_control::core
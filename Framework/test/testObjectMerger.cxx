@@ -0,0 +1,214 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testObjectMerger.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/ObjectMerger.h"
+
+#define BOOST_TEST_MODULE ObjectMerger test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <TEfficiency.h>
+#include <TGraph.h>
+#include <TH1F.h>
+#include <TH2D.h>
+#include <TH2F.h>
+#include <TList.h>
+#include <TObjString.h>
+#include <TProfile.h>
+
+namespace o2::quality_control::core
+{
+
+BOOST_AUTO_TEST_CASE(merger_resolve)
+{
+  TH1F h1("h1", "h1", 10, 0, 10);
+  TH2F h2("h2", "h2", 10, 0, 10, 10, 0, 10);
+  TProfile profile("profile", "profile", 10, 0, 10);
+  TGraph graph;
+  TEfficiency efficiency("efficiency", "efficiency", 10, 0, 10);
+  TObjString string("string");
+
+  BOOST_CHECK(ObjectMerger::resolve(&h1) == ObjectMerger::Method::Add);
+  BOOST_CHECK(ObjectMerger::resolve(&h2) == ObjectMerger::Method::Add);
+  BOOST_CHECK(ObjectMerger::resolve(&profile) == ObjectMerger::Method::Add);
+  BOOST_CHECK(ObjectMerger::resolve(&graph) == ObjectMerger::Method::Merge);
+  BOOST_CHECK(ObjectMerger::resolve(&efficiency) == ObjectMerger::Method::Merge);
+  BOOST_CHECK(ObjectMerger::resolve(&string) == ObjectMerger::Method::None);
+  BOOST_CHECK(ObjectMerger::resolve(nullptr) == ObjectMerger::Method::None);
+}
+
+BOOST_AUTO_TEST_CASE(merger_histograms)
+{
+  ObjectMerger merger;
+
+  TH2F target("h2", "h2", 10, 0, 10, 10, 0, 10);
+  target.SetDirectory(nullptr);
+  TH2F update1("h2", "h2", 10, 0, 10, 10, 0, 10);
+  update1.SetDirectory(nullptr);
+  update1.Fill(1, 1);
+  TH2F update2("h2", "h2", 10, 0, 10, 10, 0, 10);
+  update2.SetDirectory(nullptr);
+  update2.Fill(2, 2, 3);
+  TList updates;
+  updates.Add(&update1);
+  updates.Add(&update2);
+
+  BOOST_CHECK(merger.merge("h2", &target, updates));
+  BOOST_CHECK_EQUAL(target.GetSumOfWeights(), 4);
+  BOOST_CHECK_EQUAL(target.GetBinContent(target.FindBin(2, 2)), 3);
+  // the updates are left untouched
+  BOOST_CHECK_EQUAL(update2.GetSumOfWeights(), 3);
+
+  // different binning -> falls back to Merge
+  TH1F target1("h1", "h1", 10, 0, 10);
+  target1.SetDirectory(nullptr);
+  TH1F rebinned("h1", "h1", 5, 0, 10);
+  rebinned.SetDirectory(nullptr);
+  rebinned.Fill(5);
+  TList rebinnedUpdates;
+  rebinnedUpdates.Add(&rebinned);
+  BOOST_CHECK(merger.merge("h1", &target1, rebinnedUpdates));
+  BOOST_CHECK_EQUAL(target1.GetEntries(), 1);
+
+  const auto& statistics = merger.getStatistics();
+  BOOST_REQUIRE_EQUAL(statistics.count("TH2F"), 1);
+  BOOST_CHECK_EQUAL(statistics.at("TH2F").merges, 1);
+  BOOST_CHECK_EQUAL(statistics.at("TH2F").objects, 2);
+  BOOST_CHECK_EQUAL(statistics.count("TH1F"), 1);
+  BOOST_CHECK(!merger.getStatisticsSummary().empty());
+  merger.resetStatistics();
+  BOOST_CHECK(merger.getStatistics().empty());
+}
+
+BOOST_AUTO_TEST_CASE(merger_add_bins)
+{
+  auto fill = [](TH2F& histo, bool weighted, int shift) {
+    histo.SetDirectory(nullptr);
+    for (int i = 0; i < 100; i++) {
+      histo.Fill((i + shift) % 10 + 0.5, (3 * i) % 10 + 0.5, weighted ? 0.5 + i % 3 : 1.0);
+    }
+  };
+  auto checkSame = [](const TH2F& a, const TH2F& b) {
+    BOOST_CHECK_EQUAL(a.GetEntries(), b.GetEntries());
+    BOOST_CHECK_EQUAL(a.GetSumw2N(), b.GetSumw2N());
+    BOOST_CHECK_CLOSE(a.GetMean(1), b.GetMean(1), 1e-9);
+    BOOST_CHECK_CLOSE(a.GetRMS(2), b.GetRMS(2), 1e-9);
+    for (int bin = 0; bin < a.GetNcells(); bin++) {
+      BOOST_CHECK_EQUAL(a.GetBinContent(bin), b.GetBinContent(bin));
+      BOOST_CHECK_CLOSE(a.GetBinError(bin), b.GetBinError(bin), 1e-9);
+    }
+  };
+
+  for (bool targetWeighted : { false, true }) {
+    for (bool updateWeighted : { false, true }) {
+      TH2F update("update", "update", 10, 0, 10, 10, 0, 10);
+      if (updateWeighted) {
+        update.Sumw2();
+      }
+      fill(update, updateWeighted, 1);
+      TH2F viaAdd("target", "target", 10, 0, 10, 10, 0, 10);
+      TH2F viaAddBins("target", "target", 10, 0, 10, 10, 0, 10);
+      if (targetWeighted) {
+        viaAdd.Sumw2();
+        viaAddBins.Sumw2();
+      }
+      fill(viaAdd, targetWeighted, 2);
+      fill(viaAddBins, targetWeighted, 2);
+
+      viaAdd.Add(&update);
+      BOOST_CHECK(ObjectMerger::addBins(&viaAddBins, &update));
+      checkSame(viaAdd, viaAddBins);
+    }
+  }
+
+  // not supported, the target is untouched
+  TH2F target("target", "target", 10, 0, 10, 10, 0, 10);
+  target.SetDirectory(nullptr);
+  TH2F otherBinning("other", "other", 10, 0, 10, 10, 0, 20);
+  otherBinning.SetDirectory(nullptr);
+  otherBinning.Fill(1, 1);
+  BOOST_CHECK(!ObjectMerger::addBins(&target, &otherBinning));
+  TH2D otherClass("other", "other", 10, 0, 10, 10, 0, 10);
+  otherClass.SetDirectory(nullptr);
+  otherClass.Fill(1, 1);
+  BOOST_CHECK(!ObjectMerger::addBins(&target, &otherClass));
+  BOOST_CHECK_EQUAL(target.GetEntries(), 0);
+  TProfile profile("profile", "profile", 10, 0, 10);
+  profile.SetDirectory(nullptr);
+  TProfile profileUpdate("profile", "profile", 10, 0, 10);
+  profileUpdate.SetDirectory(nullptr);
+  BOOST_CHECK(!ObjectMerger::addBins(&profile, &profileUpdate));
+}
+
+BOOST_AUTO_TEST_CASE(merger_other_types)
+{
+  ObjectMerger merger;
+
+  TGraph target;
+  target.SetPoint(0, 1, 1);
+  TGraph update;
+  update.SetPoint(0, 2, 2);
+  update.SetPoint(1, 3, 3);
+  TList updates;
+  updates.Add(&update);
+  BOOST_CHECK(merger.merge("graph", &target, updates));
+  BOOST_CHECK_EQUAL(target.GetN(), 3);
+  // the failures of the Merge methods are reported
+  TObjString notAGraph("update");
+  TList wrongUpdates;
+  wrongUpdates.Add(&notAGraph);
+  BOOST_CHECK(!merger.merge("graph", &target, wrongUpdates));
+  BOOST_CHECK_EQUAL(target.GetN(), 3);
+
+  TEfficiency efficiency("efficiency", "efficiency", 10, 0, 10);
+  efficiency.SetDirectory(nullptr);
+  efficiency.Fill(true, 1);
+  TEfficiency efficiencyUpdate("efficiency", "efficiency", 10, 0, 10);
+  efficiencyUpdate.SetDirectory(nullptr);
+  efficiencyUpdate.Fill(false, 1);
+  TList efficiencyUpdates;
+  efficiencyUpdates.Add(&efficiencyUpdate);
+  BOOST_CHECK(merger.merge("efficiency", &efficiency, efficiencyUpdates));
+  BOOST_CHECK_EQUAL(efficiency.GetEfficiency(efficiency.FindFixBin(1)), 0.5);
+
+  TObjString string("string");
+  TObjString stringUpdate("update");
+  TList stringUpdates;
+  stringUpdates.Add(&stringUpdate);
+  BOOST_CHECK(!merger.merge("string", &string, stringUpdates));
+  BOOST_CHECK_EQUAL(string.GetString(), "string");
+}
+
+BOOST_AUTO_TEST_CASE(merger_reset)
+{
+  TH1F histo("histo", "histo", 10, 0, 10);
+  histo.SetDirectory(nullptr);
+  histo.Fill(1);
+  BOOST_CHECK(ObjectMerger::isResettable(&histo));
+  BOOST_CHECK(ObjectMerger::reset(&histo));
+  BOOST_CHECK_EQUAL(histo.GetEntries(), 0);
+
+  TGraph graph;
+  graph.SetPoint(0, 1, 1);
+  BOOST_CHECK(ObjectMerger::isResettable(&graph));
+  BOOST_CHECK(ObjectMerger::reset(&graph));
+  BOOST_CHECK_EQUAL(graph.GetN(), 0);
+
+  TObjString string("string");
+  BOOST_CHECK(!ObjectMerger::isResettable(&string));
+  BOOST_CHECK(!ObjectMerger::reset(&string));
+}
+
+} // namespace o2::quality_control::core
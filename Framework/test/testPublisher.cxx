@@ -9,9 +9,14 @@
 #define BOOST_TEST_MAIN
 #define BOOST_TEST_DYN_LINK
 #include "../include/Common/Exceptions.h"
+#include <TGraph.h>
+#include <TH1F.h>
 #include <TObjString.h>
+#include <TProfile.h>
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 using namespace std;
 using namespace o2::quality_control::core;
@@ -52,4 +57,119 @@ BOOST_AUTO_TEST_CASE(publisher_test)
   }
 }
 
+BOOST_AUTO_TEST_CASE(publisher_lookup)
+{
+  TaskConfig config;
+  config.taskName = "test";
+  ObjectsManager objectsManager(config);
+  std::vector<std::unique_ptr<TH1F>> histos;
+  for (int i = 0; i < 1000; i++) {
+    std::string name = "histo" + std::to_string(i);
+    histos.emplace_back(new TH1F(name.c_str(), name.c_str(), 10, 0, 10));
+    objectsManager.startPublishing(histos.back().get());
+  }
+  TH1F duplicate("histo0", "duplicate", 10, 0, 10);
+  objectsManager.startPublishing(&duplicate);
+
+  BOOST_CHECK_EQUAL(objectsManager.getObject("histo999"), histos[999].get());
+  BOOST_CHECK_EQUAL(objectsManager.getMonitorObject("histo500")->getObject(), histos[500].get());
+  BOOST_CHECK_EQUAL(objectsManager.getMonitorObject("histo500")->getTaskName(), "test");
+  // the first object published under a name is kept
+  BOOST_CHECK_EQUAL(objectsManager.getObject("histo0"), histos[0].get());
+  BOOST_CHECK_THROW(objectsManager.getObject("histo1000"), ObjectNotFoundError);
+  // an object published under another name is found with both names
+  TH1F renamed("ownName", "renamed", 10, 0, 10);
+  objectsManager.startPublishing(&renamed, "otherName");
+  BOOST_CHECK_EQUAL(objectsManager.getObject("ownName"), &renamed);
+  BOOST_CHECK_EQUAL(objectsManager.getObject("otherName"), &renamed);
+  // all of them are published anyway
+  std::unique_ptr<TObjArray> array(objectsManager.getNonOwningArray());
+  BOOST_CHECK_EQUAL(array->GetEntries(), 1002);
+}
+
+BOOST_AUTO_TEST_CASE(publisher_modified_objects)
+{
+  TaskConfig config;
+  config.taskName = "test";
+  ObjectsManager objectsManager(config);
+  TH1F h1("histo1", "histo1", 10, 0, 10);
+  TH1F h2("histo2", "histo2", 10, 0, 10);
+  TObjString s("content");
+  objectsManager.startPublishing(&h1);
+  objectsManager.startPublishing(&h2);
+  objectsManager.startPublishing(&s);
+
+  // everything is new
+  std::unique_ptr<TObjArray> modified(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 3);
+
+  // nothing changed, only the string is published as it has no checksum
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_REQUIRE_EQUAL(modified->GetEntries(), 1);
+  BOOST_CHECK_EQUAL(std::string(modified->At(0)->GetName()), "content");
+
+  h2.Fill(3);
+  s.SetString("other content");
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 2);
+  BOOST_CHECK(modified->FindObject("histo2") != nullptr);
+  BOOST_CHECK(modified->FindObject("histo1") == nullptr);
+
+  // same number of entries and sum of weights, but in other bins
+  h2.Reset();
+  h2.Fill(7);
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 2);
+  BOOST_CHECK(modified->FindObject("histo2") != nullptr);
+  BOOST_CHECK(modified->FindObject("histo1") == nullptr);
+
+  // a full publication resets the reference
+  h1.Fill(5);
+  objectsManager.markAllAsPublished();
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 1);
+  BOOST_CHECK(modified->FindObject("histo1") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(publisher_modified_graph)
+{
+  TaskConfig config;
+  config.taskName = "test";
+  ObjectsManager objectsManager(config);
+  TGraph graph(3);
+  graph.SetName("graph");
+  for (int i = 0; i < 3; i++) {
+    graph.SetPoint(i, i, i);
+  }
+  objectsManager.startPublishing(&graph);
+  std::unique_ptr<TObjArray> modified(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 1);
+
+  // only the y value of a point changes
+  graph.SetPoint(1, 1, 10);
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 1);
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(publisher_modified_profile)
+{
+  TaskConfig config;
+  config.taskName = "test";
+  ObjectsManager objectsManager(config);
+  TProfile profile("profile", "profile", 10, 0, 10);
+  profile.Fill(1, 4);
+  objectsManager.startPublishing(&profile);
+  std::unique_ptr<TObjArray> modified(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 1);
+
+  // the sum in the bin and the total number of entries do not change, only the entries of the bin do
+  profile.SetBinEntries(2, 2);
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 1);
+  modified.reset(objectsManager.getNonOwningArrayOfModified());
+  BOOST_CHECK_EQUAL(modified->GetEntries(), 0);
+}
+
 } // namespace o2::quality_control::core
@@ -0,0 +1,93 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testStorageDeduplicator.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/StorageDeduplicator.h"
+
+#define BOOST_TEST_MODULE StorageDeduplicator test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <TH1F.h>
+
+using namespace o2::quality_control::core;
+using namespace std::chrono;
+
+namespace o2::quality_control::checker
+{
+
+namespace
+{
+std::shared_ptr<MonitorObject> makeObject(double value)
+{
+  auto* histo = new TH1F("histo", "histo", 10, 0, 10);
+  histo->SetDirectory(nullptr);
+  histo->Fill(value);
+  auto mo = std::make_shared<MonitorObject>(histo, "task");
+  mo->setIsOwner(true);
+  mo->addCheck("check", "Check");
+  return mo;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(deduplicator_hash_content)
+{
+  auto mo = makeObject(1);
+  auto content = StorageDeduplicator::hashContent(*mo);
+  BOOST_CHECK(content.size > 0);
+  BOOST_CHECK(content == StorageDeduplicator::hashContent(*makeObject(1)));
+
+  // the content of the object and its quality are both part of the content
+  BOOST_CHECK(!(content == StorageDeduplicator::hashContent(*makeObject(2))));
+  mo->setQualityForCheck("check", Quality::Bad);
+  BOOST_CHECK(!(content == StorageDeduplicator::hashContent(*mo)));
+}
+
+BOOST_AUTO_TEST_CASE(deduplicator_needs_storage)
+{
+  StorageDeduplicator deduplicator(seconds(600));
+  auto one = StorageDeduplicator::hashContent(*makeObject(1));
+  auto two = StorageDeduplicator::hashContent(*makeObject(2));
+  auto start = steady_clock::now();
+
+  BOOST_CHECK(deduplicator.needsStorage("histo", one, start));
+  BOOST_CHECK(!deduplicator.needsStorage("histo", one, start + seconds(1)));
+  BOOST_CHECK(deduplicator.needsStorage("other", one, start + seconds(1))); // the objects are told apart by name
+  BOOST_CHECK(deduplicator.needsStorage("histo", two, start + seconds(2)));
+  BOOST_CHECK(!deduplicator.needsStorage("histo", two, start + seconds(601)));
+  // the version stored is refreshed once it is too old
+  BOOST_CHECK(deduplicator.needsStorage("histo", two, start + seconds(602)));
+  BOOST_CHECK(!deduplicator.needsStorage("histo", two, start + seconds(603)));
+  BOOST_CHECK_EQUAL(deduplicator.getNumberOfDeduplicated(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(deduplicator_storage_failed)
+{
+  StorageDeduplicator deduplicator(seconds(600));
+  auto one = StorageDeduplicator::hashContent(*makeObject(1));
+  auto two = StorageDeduplicator::hashContent(*makeObject(2));
+
+  BOOST_CHECK(deduplicator.needsStorage("histo", one));
+  deduplicator.storageFailed("histo", one);
+  // the identical version is stored, since the previous one is not in the repository
+  BOOST_CHECK(deduplicator.needsStorage("histo", one));
+
+  // the failure of an older version does not forget the newer one
+  BOOST_CHECK(deduplicator.needsStorage("histo", two));
+  deduplicator.storageFailed("histo", one);
+  BOOST_CHECK(!deduplicator.needsStorage("histo", two));
+  BOOST_CHECK_EQUAL(deduplicator.getNumberOfDeduplicated(), 1);
+}
+
+} // namespace o2::quality_control::checker
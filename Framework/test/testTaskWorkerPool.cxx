@@ -0,0 +1,187 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testTaskWorkerPool.cxx
+/// \author Piotr Konopka
+///
+
+#include "QualityControl/TaskWorkerPool.h"
+
+#define BOOST_TEST_MODULE TaskWorkerPool test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <TH1F.h>
+#include <stdexcept>
+#include "Framework/ConfigParamRegistry.h"
+#include "Framework/DataAllocator.h"
+#include "Framework/DataProcessingHeader.h"
+#include "Framework/InputRecord.h"
+#include "Framework/InputSpan.h"
+#include "Framework/ServiceRegistry.h"
+#include "Headers/DataHeader.h"
+#include "Headers/Stack.h"
+
+using namespace o2::framework;
+
+namespace o2::quality_control::core
+{
+
+namespace
+{
+
+/// Fills two histograms with the integers received, the second one is not published by the main instance. It throws
+/// when it receives a negative integer.
+class CountingTask : public TaskInterface
+{
+ public:
+  void initialize(InitContext&) override
+  {
+    mHisto.SetDirectory(nullptr);
+    mHistoOfWorkers.SetDirectory(nullptr);
+    getObjectsManager()->startPublishing(&mHisto);
+    getObjectsManager()->startPublishing(&mHistoOfWorkers);
+  }
+  void startOfActivity(Activity&) override {}
+  void startOfCycle() override {}
+  void monitorData(ProcessingContext& ctx) override
+  {
+    for (const auto& input : ctx.inputs()) {
+      if (input.header != nullptr) {
+        int value = *reinterpret_cast<const int*>(input.payload);
+        if (value < 0) {
+          throw std::runtime_error("negative value");
+        }
+        mHisto.Fill(value);
+        mHistoOfWorkers.Fill(value);
+      }
+    }
+  }
+  void endOfCycle() override {}
+  void endOfActivity(Activity&) override {}
+  void reset() override
+  {
+    mHisto.Reset();
+    mHistoOfWorkers.Reset();
+  }
+
+ private:
+  TH1F mHisto{ "histo", "histo", 10, 0, 10 };
+  TH1F mHistoOfWorkers{ "histoOfWorkers", "histoOfWorkers", 10, 0, 10 };
+};
+
+/// Creates the inputs and the contexts given to the pool, as DPL would.
+struct Fixture {
+  Fixture(size_t numberOfWorkers) : options(std::unique_ptr<ParamRetriever>{}), allocator(nullptr, nullptr, {})
+  {
+    config.taskName = "test";
+    inputs.push_back(InputSpec{ "data", "TST", "DATA", 0 });
+    routes.push_back(InputRoute{ inputs.back(), 0, "", 0 });
+    pool = std::make_unique<TaskWorkerPool>(numberOfWorkers, config, inputs,
+                                            [](TaskConfig&, std::shared_ptr<ObjectsManager> objectsManager) {
+                                              auto* task = new CountingTask();
+                                              task->setObjectsManager(objectsManager);
+                                              return task;
+                                            });
+    InitContext initContext{ options, services };
+    pool->initialize(initContext);
+    histo.SetDirectory(nullptr);
+    objectsManager.startPublishing(&histo);
+  }
+
+  void dispatch(int value)
+  {
+    header::DataHeader dataHeader{ "DATA", "TST", 0, sizeof(int) };
+    header::Stack headerStack{ dataHeader, DataProcessingHeader{ 0, 1 } };
+    InputSpan span{ [&](size_t i) -> const char* {
+                     return i % 2 == 0 ? reinterpret_cast<const char*>(headerStack.data())
+                                       : reinterpret_cast<const char*>(&value);
+                   },
+                    1 };
+    InputRecord record{ routes, std::move(span) };
+    ProcessingContext pCtx{ record, services, allocator };
+    pool->dispatch(pCtx);
+  }
+
+  double entriesOf(const std::string& name)
+  {
+    return dynamic_cast<TH1*>(objectsManager.getObject(name))->GetEntries();
+  }
+
+  TaskConfig config;
+  Inputs inputs;
+  std::vector<InputRoute> routes;
+  ConfigParamRegistry options;
+  ServiceRegistry services;
+  DataAllocator allocator;
+  ObjectsManager objectsManager{ config };
+  TH1F histo{ "histo", "histo", 10, 0, 10 }; // the object published by the main instance of the task
+  std::unique_ptr<TaskWorkerPool> pool;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(pool_dispatch_and_merge)
+{
+  Fixture fixture(3);
+  BOOST_CHECK_EQUAL(fixture.pool->getNumberOfWorkers(), 3);
+
+  for (int i = 0; i < 100; i++) {
+    fixture.dispatch(i % 10);
+  }
+  fixture.pool->endOfCycle(fixture.objectsManager);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 100);
+  BOOST_CHECK_EQUAL(fixture.histo.GetBinContent(fixture.histo.FindBin(3)), 10);
+  // published only by the workers, a copy is published by the main instance
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histoOfWorkers"), 100);
+
+  // the shards were reset after the merge, their content is not merged twice
+  for (int i = 0; i < 10; i++) {
+    fixture.dispatch(1);
+  }
+  fixture.pool->endOfCycle(fixture.objectsManager);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 110);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histoOfWorkers"), 110);
+  BOOST_CHECK_EQUAL(fixture.histo.GetBinContent(fixture.histo.FindBin(1)), 20);
+}
+
+BOOST_AUTO_TEST_CASE(pool_reset)
+{
+  Fixture fixture(2);
+  for (int i = 0; i < 10; i++) {
+    fixture.dispatch(i);
+  }
+  // the data processed by the workers are dropped with their shards' content
+  fixture.pool->reset();
+  fixture.pool->endOfCycle(fixture.objectsManager);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 0);
+
+  fixture.dispatch(5);
+  fixture.pool->endOfCycle(fixture.objectsManager);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(pool_worker_exception)
+{
+  Fixture fixture(2);
+  fixture.dispatch(1);
+  fixture.dispatch(-1);
+  // the data processed without error are merged before the exception is rethrown
+  BOOST_CHECK_THROW(fixture.pool->endOfCycle(fixture.objectsManager), std::runtime_error);
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 1);
+
+  // it is rethrown only once
+  fixture.dispatch(2);
+  BOOST_CHECK_NO_THROW(fixture.pool->endOfCycle(fixture.objectsManager));
+  BOOST_CHECK_EQUAL(fixture.entriesOf("histo"), 2);
+}
+
+} // namespace o2::quality_control::core
@@ -0,0 +1,62 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   testThreadPool.cxx
+/// \author Barthelemy von Haller
+///
+
+#include "QualityControl/ThreadPool.h"
+
+#define BOOST_TEST_MODULE ThreadPool test
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <stdexcept>
+
+namespace o2::quality_control::core
+{
+
+BOOST_AUTO_TEST_CASE(thread_pool_parallel_for)
+{
+  ThreadPool pool(4);
+  BOOST_CHECK_EQUAL(pool.size(), 4);
+
+  std::vector<size_t> results(1000, 0);
+  pool.parallelFor(results.size(), [&results](size_t i) { results[i] = i * i; });
+  for (size_t i = 0; i < results.size(); i++) {
+    BOOST_CHECK_EQUAL(results[i], i * i);
+  }
+
+  // nothing to do
+  pool.parallelFor(0, [](size_t) { BOOST_FAIL("should not be called"); });
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_exceptions)
+{
+  ThreadPool pool(2);
+  std::atomic<int> calls{ 0 };
+  BOOST_CHECK_THROW(pool.parallelFor(10, [&calls](size_t i) {
+    calls++;
+    if (i == 3) {
+      throw std::runtime_error("check failed");
+    }
+  }),
+                    std::runtime_error);
+  // the other indices are still processed by the thread which did not throw
+  BOOST_CHECK_GE(calls.load(), 4);
+
+  auto future = pool.submit([]() { throw std::runtime_error("job failed"); });
+  BOOST_CHECK_THROW(future.get(), std::runtime_error);
+  BOOST_CHECK_NO_THROW(pool.submit([]() {}).get());
+}
+
+} // namespace o2::quality_control::core